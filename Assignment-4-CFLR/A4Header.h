@@ -6,12 +6,17 @@
 #ifndef ANSWERS_A4HEADER_H
 #define ANSWERS_A4HEADER_H
 
-#include <utility>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
 
 #include "SVF-LLVM/SVFIRBuilder.h"
+#include "WorkList.h"
 
-using EdgeLabel = unsigned;
-
+/// Labels of the edges; the grammar derives points-to facts only, so PV, VP and VA (and their Bar
+/// labels), which would spell out the alias relation, are never derived
 enum EdgeLabelType
 {
     Addr, AddrBar,
@@ -25,41 +30,104 @@ enum EdgeLabelType
     VF, VFBar,
     VA, VABar,
     LV, LVBar,
+    NumEdgeLabels
 };
 
+static_assert(NumEdgeLabels < 1u << CFLREdge::LabelBits, "edge labels do not fit in a packed edge key");
+
 
 /**
- * The edge type of CFL-reachability
+ * A context-free grammar over edge labels in normal form: every production has one or two symbols
+ * on its right-hand side. Productions are indexed by their right-hand symbols, so that a new edge
+ * finds the productions it can take part in without a search.
  */
-struct CFLREdge
+class CFLGrammar
 {
-    unsigned src;   // source
-    unsigned dst;   // target
-    EdgeLabel label;
+public:
+    /// lhs ::= rhs
+    struct UnaryRule
+    {
+        EdgeLabel lhs;
+    };
 
-    CFLREdge(unsigned src, unsigned dst, EdgeLabel lbl) :
-            src(src), dst(dst), label(lbl)
-    {}
+    /// lhs ::= first second; 'other' is the right-hand symbol that is not the index
+    struct BinaryRule
+    {
+        EdgeLabel lhs;
+        EdgeLabel other;
+    };
+
+    /// The points-to grammar of the analysis
+    CFLGrammar();
+
+    void addUnaryRule(EdgeLabel lhs, EdgeLabel rhs);
+    void addBinaryRule(EdgeLabel lhs, EdgeLabel first, EdgeLabel second);
+
+    /// Productions lhs ::= label
+    inline const std::vector<UnaryRule> &getUnaryRules(EdgeLabel label) const
+    { return unaryRules[label]; }
+
+    /// Productions lhs ::= label other
+    inline const std::vector<BinaryRule> &getRulesByFirst(EdgeLabel label) const
+    { return firstRules[label]; }
+
+    /// Productions lhs ::= other label
+    inline const std::vector<BinaryRule> &getRulesBySecond(EdgeLabel label) const
+    { return secondRules[label]; }
+
+protected:
+    std::vector<UnaryRule> unaryRules[NumEdgeLabels];
+    std::vector<BinaryRule> firstRules[NumEdgeLabels];
+    std::vector<BinaryRule> secondRules[NumEdgeLabels];
+};
+
+
+/**
+ * A set of node IDs, kept as a sorted vector while small. Once a set holds more than SmallSize
+ * elements and a bitset up to its largest element is no bigger than the vector, the same storage
+ * switches to 32-bit words of a bitset. Both forms iterate in ascending order.
+ */
+class NodeSet
+{
+public:
+    static const unsigned SmallSize = 32;
+
+    inline size_t size() const
+    { return count; }
 
-    inline bool operator<(const CFLREdge &rhs) const
+    inline bool empty() const
+    { return count == 0; }
+
+    inline bool test(unsigned n) const
     {
-        if (src != rhs.src) return src < rhs.src;
-        if (dst != rhs.dst) return dst < rhs.dst;
-        return label < rhs.label;
+        if (dense)
+            return n / 32 < data.size() && (data[n / 32] >> (n % 32) & 1);
+        return std::binary_search(data.begin(), data.end(), n);
     }
 
-    inline bool operator==(const CFLREdge &rhs) const
+    /// Insert n; returns false if it was in the set already
+    bool insert(unsigned n);
+
+    template<class Fn>
+    inline void forEach(Fn fn) const
     {
-        return (src == rhs.src) && (dst == rhs.dst) && (label == rhs.label);
+        if (!dense)
+        {
+            for (unsigned n : data)
+                fn(n);
+            return;
+        }
+        for (unsigned word = 0; word < data.size(); ++word)
+        {
+            for (uint32_t bits = data[word]; bits; bits &= bits - 1)
+                fn(word * 32 + __builtin_ctz(bits));
+        }
     }
-};
 
-
-template<>
-struct std::hash<CFLREdge>
-{
-    size_t operator()(const CFLREdge &edge) const
-    { return ((uint64_t) edge.src << 32) | (uint64_t) edge.dst; }
+protected:
+    std::vector<uint32_t> data;     ///< sorted elements, or the bitset words once dense
+    uint32_t count = 0;
+    bool dense = false;
 };
 
 
@@ -69,9 +137,6 @@ struct std::hash<CFLREdge>
 class CFLRGraph
 {
 public:
-    /// We use a source -> label -> target map to represent the adjacency list of the predecessors/successors of nodes.
-    using DataMap = std::unordered_map<unsigned, std::unordered_map<EdgeLabel, std::unordered_set<unsigned>>>;
-
     /// Construct a graph from a PAG
     explicit CFLRGraph(SVF::SVFIR *pag);
 
@@ -82,72 +147,172 @@ public:
      * @param label the label of the edge
      * @return true of the edge already exists, false otherwise
      */
-    bool hasEdge(unsigned src, unsigned dst, EdgeLabel label);
+    inline bool hasEdge(unsigned src, unsigned dst, EdgeLabel label) const
+    { return src < succs.size() && succs[src].sets[label].test(dst); }
 
     /**
      * Add an edge to the graph
      * @param src the source node of the edge
      * @param dst the target node of the edge
      * @param label the label of the edge
+     * @return true if the edge is new, false if the graph had it already
+     */
+    bool addEdge(unsigned src, unsigned dst, EdgeLabel label);
+
+    /**
+     * The two halves of addEdge, for callers that guard the sets of src and dst themselves, like
+     * the parallel solver. Both nodes must have edges already, so that no node vector grows.
+     * Each returns true if its half of the edge is new.
      */
-    void addEdge(unsigned src, unsigned dst, EdgeLabel label);
+    inline bool addSuccessor(unsigned src, unsigned dst, EdgeLabel label)
+    {
+        assert(src < succs.size() && dst < succs.size() && "node without edges");
+        return succs[src].sets[label].insert(dst);
+    }
+
+    inline bool addPredecessor(unsigned src, unsigned dst, EdgeLabel label)
+    {
+        assert(src < preds.size() && dst < preds.size() && "node without edges");
+        return preds[dst].sets[label].insert(src);
+    }
 
-    DataMap &getSuccessorMap()
-    { return succMap; }
+    /// One more than the largest node ID with an edge
+    inline unsigned getNumNodes() const
+    { return succs.size(); }
 
-    DataMap &getPredecessorMap()
-    { return predMap; }
+    /// Call fn(dst) for each edge src --label--> dst, in ascending order of dst
+    template<class Fn>
+    inline void forEachSuccessor(unsigned src, EdgeLabel label, Fn fn) const
+    {
+        if (src < succs.size())
+            succs[src].sets[label].forEach(fn);
+    }
+
+    /// Call fn(src) for each edge src --label--> dst, in ascending order of src
+    template<class Fn>
+    inline void forEachPredecessor(unsigned dst, EdgeLabel label, Fn fn) const
+    {
+        if (dst < preds.size())
+            preds[dst].sets[label].forEach(fn);
+    }
+
+    /// Call fn(src, dst, label) for each edge, ordered by source, then label, then target
+    template<class Fn>
+    inline void forEachEdge(Fn fn) const
+    {
+        for (unsigned src = 0; src < succs.size(); ++src)
+        {
+            for (EdgeLabel label = 0; label < NumEdgeLabels; ++label)
+                succs[src].sets[label].forEach([&](unsigned dst) { fn(src, dst, label); });
+        }
+    }
+
+    /// A gep statement: dst points to the field at offset of each object src points to, or to
+    /// the whole object for a variant gep
+    struct GepEdge
+    {
+        unsigned src;
+        unsigned dst;
+        SVF::APOffset offset;
+        bool variant;
+    };
+
+    /// The gep statements, which the solver applies through field objects rather than labels
+    inline const std::vector<GepEdge> &getGepEdges() const
+    { return gepEdges; }
 
 protected:
-    DataMap predMap;   // holding predecessors
-    DataMap succMap;   // holding successors
+    /// The neighbours of one node, by label
+    struct Adjacency
+    {
+        NodeSet sets[NumEdgeLabels];
+    };
+
+    std::vector<Adjacency> preds;   // holding predecessors, indexed by node
+    std::vector<Adjacency> succs;   // holding successors, indexed by node
+    std::vector<GepEdge> gepEdges;
 };
 
 
 /**
- * FIFO worklist
+ * A boolean matrix over nodes numbered from 0: each row is a bitset of 64-bit words, allocated
+ * when its first bit is set, so that a sparse matrix costs little more than its non-empty rows
  */
-template<class T>
-class WorkList
+class BoolMatrix
 {
 public:
-    /// Check whether the worklist is empty.
+    explicit BoolMatrix(unsigned n = 0) :
+            rows(n), numWords((n + 63) / 64)
+    {}
+
+    inline unsigned getNumRows() const
+    { return rows.size(); }
+
+    inline unsigned getNumWords() const
+    { return numWords; }
+
+    inline bool hasRow(unsigned i) const
+    { return !rows[i].empty(); }
+
+    /// The words of row i, or nullptr if the row is empty
+    inline const uint64_t *getRow(unsigned i) const
+    { return rows[i].empty() ? nullptr : rows[i].data(); }
+
+    inline uint64_t *getOrAddRow(unsigned i)
+    {
+        if (rows[i].empty())
+            rows[i].assign(numWords, 0);
+        return rows[i].data();
+    }
+
+    inline void set(unsigned i, unsigned j)
+    { getOrAddRow(i)[j / 64] |= 1ull << (j % 64); }
+
     inline bool empty() const
-    { return data_list.empty(); }
+    {
+        for (const std::vector<uint64_t> &row : rows)
+        {
+            if (!row.empty())
+                return false;
+        }
+        return true;
+    }
 
-    /// Clear the worklist
     inline void clear()
     {
-        data_list.clear();
-        data_set.clear();
+        for (std::vector<uint64_t> &row : rows)
+            std::vector<uint64_t>().swap(row);
     }
 
-    /// Push a data into the END work list.
-    inline bool push(const T &data)
+    /// Grow to n rows and columns, keeping the bits set so far
+    inline void resize(unsigned n)
     {
-        if (data_set.find(data) == data_set.end())
+        numWords = (n + 63) / 64;
+        rows.resize(n);
+        for (std::vector<uint64_t> &row : rows)
         {
-            this->data_list.push_back(data);
-            this->data_set.insert(data);
-            return true;
+            if (!row.empty())
+                row.resize(numWords, 0);
         }
-        else
-            return false;
     }
 
-    /// Pop a data from the FRONT of work list.
-    inline T pop()
+    /// Call fn(j) for each set bit (i, j), in ascending order of j
+    template<class Fn>
+    inline void forEachInRow(unsigned i, Fn fn) const
     {
-        assert(!this->empty() && "work list is empty");
-        T data = this->data_list.front();
-        this->data_list.pop_front();
-        this->data_set.erase(data);
-        return data;
+        const uint64_t *row = getRow(i);
+        if (!row)
+            return;
+        for (unsigned word = 0; word < numWords; ++word)
+        {
+            for (uint64_t bits = row[word]; bits; bits &= bits - 1)
+                fn(word * 64 + __builtin_ctzll(bits));
+        }
     }
 
 protected:
-    std::unordered_set<T> data_set;       ///< to avoid duplicate elements
-    std::deque<T> data_list;     ///< to access the elements at both the beginning and the end
+    std::vector<std::vector<uint64_t>> rows;
+    unsigned numWords;
 };
 
 
@@ -156,11 +321,32 @@ protected:
  */
 class CFLR
 {
-    WorkList<CFLREdge> workList;
+    WorkList<CFLREdge, FIFOOrder, CFLREdgeSet> workList;
     CFLRGraph *graph;
+    CFLGrammar grammar;
+
+    SVF::SVFIR *pag;
+    std::map<std::pair<unsigned, SVF::APOffset>, unsigned> fieldObjs;  ///< (object, offset) -> field object
+
+    // The matrix backend keeps its facts across the rounds of solve, so a round joins its seed only
+    std::vector<unsigned> matrixNodes;     ///< node of each matrix index
+    std::vector<unsigned> matrixIndexOf;   ///< matrix index of each node, ~0u if it has none
+    std::vector<BoolMatrix> matrices;      ///< the facts so far, one matrix per label
+
+    /// Add a derived edge to the graph and the worklist unless the graph has it already
+    void addDerivedEdge(unsigned src, unsigned dst, EdgeLabel label);
+    /// Add the PTBar and PT edges the gep statements derive through the field objects resolved so
+    /// far, or with create through new field objects as well; the new edges go to added
+    void addFieldEdges(bool create, std::vector<CFLREdge> &added);
 
 public:
-    CFLR() : graph(nullptr)
+    /// Backends of solve
+    enum class SolverMode
+    {
+        Worklist, Matrix, Auto
+    };
+
+    CFLR() : graph(nullptr), pag(nullptr)
     {}
 
     ~CFLR()
@@ -168,10 +354,34 @@ public:
 
     /// Build a graph from PAG
     void buildGraph(SVF::PAG *pag);
-    /// The dynamic-programming CFL-reachability algorithm.
+    /// The dynamic-programming CFL-reachability algorithm, with the backend of the solver mode
     void solve();
     /// Dump results into a file
     void dumpResult();
+
+    inline void setSolverMode(SolverMode mode)
+    { solverMode = mode; }
+
+    /// Use the parallel worklist backend with n threads when n > 1
+    inline void setNumThreads(unsigned n)
+    { numThreads = std::max(n, 1u); }
+
+    static bool parseSolverMode(const std::string &name, SolverMode &mode);
+
+protected:
+    // The backends solve the graph to a fixpoint; seed holds the edges not joined yet
+    /// Derive edges one at a time from a worklist
+    void solveWorklist(const std::vector<CFLREdge> &seed);
+    /// The worklist backend on numThreads threads (CFLRParallel.cpp)
+    void solveParallel(const std::vector<CFLREdge> &seed);
+    /// Derive whole rows of boolean matrices per round, one matrix per label (CFLRMatrix.cpp); the
+    /// matrices persist until solve returns
+    void solveMatrix(const std::vector<CFLREdge> &seed);
+    /// Whether the graph is small and dense enough for the matrix backend to be the faster one
+    bool preferMatrix() const;
+
+    SolverMode solverMode = SolverMode::Auto;
+    unsigned numThreads = 1;
 };
 
 #endif //ANSWERS_A4HEADER_H
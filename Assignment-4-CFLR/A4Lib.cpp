@@ -74,26 +74,161 @@ CFLRGraph::CFLRGraph(SVF::SVFIR *pag)
         addEdge(edge->getSrcID(), edge->getDstID(), Load);
         addEdge(edge->getDstID(), edge->getSrcID(), LoadBar);
     }
+
+    // Geps select field objects, so they are kept aside instead of becoming labelled edges
+    for (SVF::PAGEdge *edge : pag->getSVFStmtSet(SVF::PAGEdge::Gep))
+    {
+        const SVF::GepStmt *gep = SVF::SVFUtil::cast<SVF::GepStmt>(edge);
+        bool variant = gep->isVariantFieldGep();
+        gepEdges.push_back({gep->getSrcID(), gep->getDstID(), variant ? 0 : gep->getConstantStructFldIdx(), variant});
+    }
+}
+
+
+bool CFLRGraph::addEdge(unsigned int src, unsigned int dst, EdgeLabel label)
+{
+    unsigned numNodes = std::max(src, dst) + 1;
+    if (succs.size() < numNodes)
+    {
+        succs.resize(numNodes);
+        preds.resize(numNodes);
+    }
+    if (!succs[src].sets[label].insert(dst))
+        return false;
+    preds[dst].sets[label].insert(src);
+    return true;
+}
+
+
+bool NodeSet::insert(unsigned n)
+{
+    if (dense)
+    {
+        if (n / 32 >= data.size())
+            data.resize(n / 32 + 1, 0);
+        uint32_t bit = 1u << (n % 32);
+        if (data[n / 32] & bit)
+            return false;
+        data[n / 32] |= bit;
+        ++count;
+        return true;
+    }
+
+    auto pos = std::lower_bound(data.begin(), data.end(), n);
+    if (pos != data.end() && *pos == n)
+        return false;
+    data.insert(pos, n);
+    ++count;
+    // The bitset takes one word per 32 IDs up to the largest element, the vector one per element
+    if (count > SmallSize && data.back() / 32 < count)
+    {
+        std::vector<uint32_t> bits(data.back() / 32 + 1, 0);
+        for (unsigned m : data)
+            bits[m / 32] |= 1u << (m % 32);
+        data.swap(bits);
+        dense = true;
+    }
+    return true;
 }
 
 
-bool CFLRGraph::hasEdge(unsigned int src, unsigned int dst, EdgeLabel EdgeLabel)
+CFLGrammar::CFLGrammar()
 {
-    return succMap[src][EdgeLabel].count(dst);
+    // PTBar(o, p): object o flows to pointer p. Stores and loads go through the object node, which
+    // stands for the contents of the object as in the constraint graph of Andersen:
+    //   SV(v, o): v is stored into o, via a pointer to o
+    //   LV(o, q): q is loaded from o, via a pointer to o
+    // Each production has its mirror over the Bar labels, so the PT edges are PTBar reversed.
+    addUnaryRule(PTBar, Addr);
+    addBinaryRule(PTBar, PTBar, VF);
+    addUnaryRule(VF, Copy);
+    addUnaryRule(VF, SV);
+    addUnaryRule(VF, LV);
+    addBinaryRule(SV, Store, PT);
+    addBinaryRule(LV, PTBar, Load);
+
+    addUnaryRule(PT, AddrBar);
+    addBinaryRule(PT, VFBar, PT);
+    addUnaryRule(VFBar, CopyBar);
+    addUnaryRule(VFBar, SVBar);
+    addUnaryRule(VFBar, LVBar);
+    addBinaryRule(SVBar, PTBar, StoreBar);
+    addBinaryRule(LVBar, LoadBar, PT);
 }
 
 
-void CFLRGraph::addEdge(unsigned int src, unsigned int dst, EdgeLabel EdgeLabel)
+void CFLGrammar::addUnaryRule(EdgeLabel lhs, EdgeLabel rhs)
 {
-    succMap[src][EdgeLabel].insert(dst);
-    predMap[dst][EdgeLabel].insert(src);
+    unaryRules[rhs].push_back({lhs});
+}
+
+
+void CFLGrammar::addBinaryRule(EdgeLabel lhs, EdgeLabel first, EdgeLabel second)
+{
+    firstRules[first].push_back({lhs, second});
+    secondRules[second].push_back({lhs, first});
+}
+
+
+void CFLR::addDerivedEdge(unsigned src, unsigned dst, EdgeLabel label)
+{
+    if (graph->addEdge(src, dst, label))
+        workList.push(CFLREdge(src, dst, label));
+}
+
+
+void CFLR::addFieldEdges(bool create, std::vector<CFLREdge> &added)
+{
+    // o --PTBar--> q --Gep--> p  =>  f --PTBar--> p and p --PT--> f, where f is the field object
+    // of o the gep selects. New field objects are created in (object, offset) order once nothing
+    // else can be derived, as in Andersen's solver, so the two number them alike.
+    auto addFieldEdge = [&](unsigned f, unsigned p) {
+        if (graph->addEdge(f, p, PTBar))
+            added.emplace_back(f, p, PTBar);
+        if (graph->addEdge(p, f, PT))
+            added.emplace_back(p, f, PT);
+    };
+    std::vector<std::tuple<unsigned, SVF::APOffset, unsigned>> lookups;
+    std::vector<unsigned> objs;
+    for (const CFLRGraph::GepEdge &gep : graph->getGepEdges())
+    {
+        objs.clear();
+        graph->forEachPredecessor(gep.src, PTBar, [&](unsigned o) { objs.push_back(o); });
+        for (unsigned o : objs)
+        {
+            if (gep.variant)
+            {
+                addFieldEdge(pag->getFIObjVar(o), gep.dst);
+                continue;
+            }
+            auto it = fieldObjs.find({o, gep.offset});
+            if (it != fieldObjs.end())
+                addFieldEdge(it->second, gep.dst);
+            else if (create)
+                lookups.emplace_back(o, gep.offset, gep.dst);
+        }
+    }
+
+    std::sort(lookups.begin(), lookups.end());
+    for (auto const& lookup : lookups)
+    {
+        unsigned o = std::get<0>(lookup);
+        SVF::APOffset offset = std::get<1>(lookup);
+        auto it = fieldObjs.find({o, offset});
+        if (it == fieldObjs.end())
+            it = fieldObjs.emplace(std::make_pair(o, offset), pag->getGepObjVar(o, offset)).first;
+        addFieldEdge(it->second, std::get<2>(lookup));
+    }
 }
 
 
 void CFLR::buildGraph(SVF::PAG *pag)
 {
     if (!graph)
+    {
         graph = new CFLRGraph(pag);
+        this->pag = pag;
+    }
 }
 
 
@@ -107,25 +242,11 @@ void CFLR::dumpResult()
         return;
     }
 
-    // Collect S-edges
-    std::map<unsigned, std::set<unsigned >> edgeSet;  // ordered edge set
-    for (auto &nodeItr : graph->getSuccessorMap())
+    // Write S-edges; the graph keeps sources and targets in ascending order
+    for (unsigned src = 0; src < graph->getNumNodes(); ++src)
     {
-        unsigned src = nodeItr.first;
-        for (auto &lblItr : nodeItr.second)
-        {
-            if (lblItr.first == PT)
-                for (auto dst : lblItr.second)
-                    edgeSet[src].insert(dst);
-        }
+        graph->forEachSuccessor(src, PT, [&](unsigned dst) {
+            outFile << src << '\t' << "points to" << '\t' << dst << std::endl;
+        });
     }
-
-    // Write S-edges
-    for (auto &srcItr : edgeSet)
-    {
-        for (auto dst : srcItr.second)
-        {
-            outFile << srcItr.first << '\t' << "points to" << '\t' << dst << std::endl;
-        }
-    }
-}
\ No newline at end of file
+}
@@ -9,6 +9,16 @@ using namespace SVF;
 using namespace llvm;
 using namespace std;
 
+static Option<std::string> SolverModeName(
+        "cflr-solver",
+        "Backend of the CFL-reachability solver: worklist, matrix, or auto to choose by graph density",
+        "auto");
+
+static Option<unsigned> NumThreads(
+        "threads",
+        "Number of solver threads; more than one runs the worklist backend in parallel",
+        1);
+
 int main(int argc, char **argv)
 {
     auto moduleNameVec =
@@ -22,8 +32,15 @@ int main(int argc, char **argv)
    // pag->dump();
 
     CFLR solver;
+    CFLR::SolverMode mode;
+    if (!CFLR::parseSolverMode(SolverModeName(), mode))
+    {
+        std::cerr << "unknown solver '" << SolverModeName() << "'\n";
+        return 1;
+    }
+    solver.setSolverMode(mode);
+    solver.setNumThreads(NumThreads());
     solver.buildGraph(pag);
-    // TODO: complete this method
     solver.solve();
     solver.dumpResult();
 
@@ -32,11 +49,88 @@ int main(int argc, char **argv)
 }
 
 
+bool CFLR::parseSolverMode(const std::string &name, SolverMode &mode)
+{
+    if (name == "worklist")
+        mode = SolverMode::Worklist;
+    else if (name == "matrix")
+        mode = SolverMode::Matrix;
+    else if (name == "auto")
+        mode = SolverMode::Auto;
+    else
+        return false;
+    return true;
+}
+
+
 void CFLR::solve()
 {
-    // TODO: complete this function. The implementations of graph and worklist are provided.
-    //  You need to:
-    //  1. implement the grammar production rules into code;
-    //  2. implement the dynamic-programming CFL-reachability algorithm.
-    //  You may need to add your new methods to 'CFLRGraph' and 'CFLR'.
+    // The backend solves the labelled edges; the gep statements then add the edges through the
+    // field objects known so far, and only when those bring nothing new through new ones. The
+    // backend resumes from each batch of added edges until there are none.
+    bool matrix = solverMode == SolverMode::Matrix || (solverMode == SolverMode::Auto && preferMatrix());
+    std::vector<CFLREdge> seed;
+    graph->forEachEdge([&](unsigned src, unsigned dst, EdgeLabel label) {
+        seed.emplace_back(src, dst, label);
+    });
+    while (!seed.empty())
+    {
+        // The worklist backend packs edges into keys that only hold 2^29 node IDs; the parallel
+        // one keeps no keys and takes over on larger graphs, on a single thread if need be
+        if (matrix)
+            solveMatrix(seed);
+        else if (numThreads > 1 || !CFLREdge::fitsKey(graph->getNumNodes()))
+            solveParallel(seed);
+        else
+            solveWorklist(seed);
+        seed.clear();
+        addFieldEdges(false, seed);
+        if (seed.empty())
+            addFieldEdges(true, seed);
+    }
+    // The matrix backend kept its facts for the next batch only
+    std::vector<BoolMatrix>().swap(matrices);
+    matrixNodes.clear();
+    matrixIndexOf.clear();
+}
+
+
+void CFLR::solveWorklist(const std::vector<CFLREdge> &seed)
+{
+    // Semi-naive evaluation: every edge enters the worklist once, when it is first derived, and is
+    // then joined only against the edges already in the graph. Of two adjacent edges, the one popped
+    // later finds the other in the graph, so no derivation is missed and none is searched for twice
+    // from the same edge.
+    for (const CFLREdge &edge : seed)
+        workList.push(edge);
+
+    // The ends are copied out before joining: adding edges may grow the node vector or even
+    // insert into the very set being iterated
+    std::vector<unsigned> ends;
+    auto collect = [&](unsigned n) { ends.push_back(n); };
+    while (!workList.empty())
+    {
+        CFLREdge edge = workList.pop();
+
+        for (const CFLGrammar::UnaryRule &rule : grammar.getUnaryRules(edge.label))
+            addDerivedEdge(edge.src, edge.dst, rule.lhs);
+
+        // lhs ::= label other: extend the edge at its target
+        for (const CFLGrammar::BinaryRule &rule : grammar.getRulesByFirst(edge.label))
+        {
+            ends.clear();
+            graph->forEachSuccessor(edge.dst, rule.other, collect);
+            for (unsigned dst : ends)
+                addDerivedEdge(edge.src, dst, rule.lhs);
+        }
+
+        // lhs ::= other label: extend the edge at its source
+        for (const CFLGrammar::BinaryRule &rule : grammar.getRulesBySecond(edge.label))
+        {
+            ends.clear();
+            graph->forEachPredecessor(edge.src, rule.other, collect);
+            for (unsigned src : ends)
+                addDerivedEdge(src, edge.dst, rule.lhs);
+        }
+    }
 }
@@ -0,0 +1,179 @@
+/**
+ * CFLRMatrix.cpp
+ * @author kisslune
+ */
+
+#include "A4Header.h"
+
+namespace
+{
+/// The matrix backend takes graphs of at most this many nodes with edges: its rows are dense
+const unsigned MatrixMaxNodes = 8192;
+
+/// ... and with at least this many edges per node, Bar edges included
+const double MatrixMinEdgesPerNode = 3.5;
+
+/// Number the nodes with edges from 0, in ascending order of ID
+void compactNodes(const CFLRGraph &graph, std::vector<unsigned> &nodes, std::vector<unsigned> &indexOf,
+                  uint64_t &numEdges)
+{
+    const unsigned none = ~0u;
+    indexOf.assign(graph.getNumNodes(), none);
+    numEdges = 0;
+    graph.forEachEdge([&](unsigned src, unsigned dst, EdgeLabel) {
+        indexOf[src] = indexOf[dst] = 0;
+        ++numEdges;
+    });
+    nodes.clear();
+    for (unsigned n = 0; n < indexOf.size(); ++n)
+    {
+        if (indexOf[n] == none)
+            continue;
+        indexOf[n] = nodes.size();
+        nodes.push_back(n);
+    }
+}
+}
+
+
+bool CFLR::preferMatrix() const
+{
+    // A row operation handles 64 columns at a time, and pays for all of them; it wins once the
+    // derived relations are dense. They are, once the input has a few edges per node: loads and
+    // stores then connect most pointers, and the sets of most of them become large.
+    std::vector<unsigned> nodes;
+    std::vector<unsigned> indexOf;
+    uint64_t numEdges;
+    compactNodes(*graph, nodes, indexOf, numEdges);
+    uint64_t n = nodes.size();
+    return n > 0 && n <= MatrixMaxNodes && numEdges >= MatrixMinEdgesPerNode * n;
+}
+
+
+void CFLR::solveMatrix(const std::vector<CFLREdge> &seed)
+{
+    // Semi-naive evaluation over matrices, a round at a time: each round joins the facts new in
+    // the last round (delta) against all facts so far (full), and the facts it finds for the
+    // first time are the delta of the next round; the first delta is the seed. For
+    // lhs ::= first second, a new row i of first ORs row k of second into row i of lhs for each
+    // bit k; a new row k of second is ORed into each row i of lhs whose row of first has bit k.
+    // Both loops run over whole 64-bit words.
+    // The matrices outlive the call: the first seed is the whole graph, the later ones are the
+    // edges through field objects, whose new nodes are numbered on the way and widen the matrices.
+    const unsigned none = ~0u;
+    auto number = [&](unsigned node) {
+        if (node >= matrixIndexOf.size())
+            matrixIndexOf.resize(node + 1, none);
+        if (matrixIndexOf[node] == none)
+        {
+            matrixIndexOf[node] = matrixNodes.size();
+            matrixNodes.push_back(node);
+        }
+    };
+    for (const CFLREdge &edge : seed)
+    {
+        number(edge.src);
+        number(edge.dst);
+    }
+    const std::vector<unsigned> &nodes = matrixNodes;
+    unsigned n = nodes.size();
+    if (matrices.empty())
+        matrices.assign(NumEdgeLabels, BoolMatrix(n));
+    else if (matrices[0].getNumRows() < n)
+    {
+        for (BoolMatrix &matrix : matrices)
+            matrix.resize(n);
+    }
+    std::vector<BoolMatrix> &full = matrices;
+    std::vector<BoolMatrix> delta(NumEdgeLabels, BoolMatrix(n));
+    std::vector<BoolMatrix> next(NumEdgeLabels, BoolMatrix(n));
+    for (const CFLREdge &edge : seed)
+    {
+        full[edge.label].set(matrixIndexOf[edge.src], matrixIndexOf[edge.dst]);
+        delta[edge.label].set(matrixIndexOf[edge.src], matrixIndexOf[edge.dst]);
+    }
+
+    unsigned numWords = (n + 63) / 64;
+    std::vector<uint64_t> fresh(numWords);
+    // OR row src into row i of label, and the bits that were not there yet into the next delta
+    auto addRow = [&](EdgeLabel label, unsigned i, const uint64_t *src) {
+        uint64_t *dst = full[label].getOrAddRow(i);
+        uint64_t any = 0;
+        for (unsigned w = 0; w < numWords; ++w)
+        {
+            uint64_t bits = src[w] & ~dst[w];
+            fresh[w] = bits;
+            dst[w] |= bits;
+            any |= bits;
+        }
+        if (!any)
+            return;
+        uint64_t *nextRow = next[label].getOrAddRow(i);
+        for (unsigned w = 0; w < numWords; ++w)
+            nextRow[w] |= fresh[w];
+    };
+
+    std::vector<uint64_t> deltaRows(numWords);
+    while (true)
+    {
+        bool changed = false;
+        for (EdgeLabel label = 0; label < NumEdgeLabels; ++label)
+        {
+            const BoolMatrix &newFacts = delta[label];
+            if (newFacts.empty())
+                continue;
+            changed = true;
+
+            for (unsigned i = 0; i < n; ++i)
+            {
+                const uint64_t *row = newFacts.getRow(i);
+                if (!row)
+                    continue;
+                for (const CFLGrammar::UnaryRule &rule : grammar.getUnaryRules(label))
+                    addRow(rule.lhs, i, row);
+                for (const CFLGrammar::BinaryRule &rule : grammar.getRulesByFirst(label))
+                {
+                    newFacts.forEachInRow(i, [&](unsigned k) {
+                        if (const uint64_t *other = full[rule.other].getRow(k))
+                            addRow(rule.lhs, i, other);
+                    });
+                }
+            }
+
+            if (grammar.getRulesBySecond(label).empty())
+                continue;
+            std::fill(deltaRows.begin(), deltaRows.end(), 0);
+            for (unsigned k = 0; k < n; ++k)
+            {
+                if (newFacts.hasRow(k))
+                    deltaRows[k / 64] |= 1ull << (k % 64);
+            }
+            for (const CFLGrammar::BinaryRule &rule : grammar.getRulesBySecond(label))
+            {
+                for (unsigned i = 0; i < n; ++i)
+                {
+                    const uint64_t *row = full[rule.other].getRow(i);
+                    if (!row)
+                        continue;
+                    for (unsigned w = 0; w < numWords; ++w)
+                    {
+                        for (uint64_t bits = row[w] & deltaRows[w]; bits; bits &= bits - 1)
+                            addRow(rule.lhs, i, newFacts.getRow(w * 64 + __builtin_ctzll(bits)));
+                    }
+                }
+            }
+        }
+        if (!changed)
+            break;
+        // The graph gets each fact once, in the round that finds it, and so ends up with the same
+        // edges as after the worklist backend
+        for (EdgeLabel label = 0; label < NumEdgeLabels; ++label)
+        {
+            for (unsigned i = 0; i < n; ++i)
+                next[label].forEachInRow(i, [&](unsigned j) { graph->addEdge(nodes[i], nodes[j], label); });
+        }
+        delta.swap(next);
+        for (BoolMatrix &matrix : next)
+            matrix.clear();
+    }
+}
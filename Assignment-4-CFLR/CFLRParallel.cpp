@@ -0,0 +1,192 @@
+/**
+ * CFLRParallel.cpp
+ * @author kisslune
+ */
+
+#include "A4Header.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+/// Nodes share this many locks; each guards the successor and predecessor sets of its nodes
+const unsigned NumLockStripes = 4096;
+
+/// Edges derived for a thread are handed over in batches of this many
+const size_t HandOverBatch = 64;
+
+/// The edges a thread owns. The owner takes from the back, thieves from the front.
+struct ThreadQueue
+{
+    std::mutex lock;
+    std::deque<CFLREdge> edges;
+};
+}
+
+
+void CFLR::solveParallel(const std::vector<CFLREdge> &seed)
+{
+    // Each thread owns the edges whose source it is given, and joins them as solveWorklist does.
+    // A join reads the sets of one node v, and an edge ending at v enters them under the lock of
+    // v before it is queued: of two edges meeting at v, the one joined later sees the other, as
+    // in the sequential solver. The graph's sets are the concurrent edge set. The edges of one
+    // join share their source or their target, so they are checked against its set under one
+    // lock; an edge is queued by the thread that finds it new there, which may happen on both
+    // sides at once, and then it is only joined twice. An idle thread steals half of the queue
+    // of another.
+    std::vector<std::mutex> stripes(NumLockStripes);
+    auto stripeOf = [&](unsigned n) -> std::mutex & { return stripes[n % NumLockStripes]; };
+    auto ownerOf = [&](unsigned src) { return src % numThreads; };
+    std::vector<ThreadQueue> queues(numThreads);
+    // Edges queued, in a batch or being joined; the solver is done when it drops to zero
+    std::atomic<uint64_t> pending(0);
+    for (const CFLREdge &edge : seed)
+    {
+        queues[ownerOf(edge.src)].edges.push_back(edge);
+        ++pending;
+    }
+
+    auto worker = [&](unsigned self) {
+        std::vector<std::vector<CFLREdge>> handOver(numThreads);
+        std::vector<CFLREdge> local;
+        std::vector<unsigned> ends;
+        std::vector<unsigned> fresh;
+        auto collect = [&](unsigned n) { ends.push_back(n); };
+
+        auto flush = [&](unsigned owner) {
+            std::lock_guard<std::mutex> guard(queues[owner].lock);
+            queues[owner].edges.insert(queues[owner].edges.end(), handOver[owner].begin(), handOver[owner].end());
+            handOver[owner].clear();
+        };
+        auto queue = [&](unsigned src, unsigned dst, EdgeLabel label) {
+            ++pending;
+            unsigned owner = ownerOf(src);
+            handOver[owner].emplace_back(src, dst, label);
+            if (handOver[owner].size() >= HandOverBatch)
+                flush(owner);
+        };
+        // Add src --label--> dst for each dst in ends, and queue the new ones
+        auto addDerivedFrom = [&](unsigned src, EdgeLabel label) {
+            fresh.clear();
+            {
+                std::lock_guard<std::mutex> guard(stripeOf(src));
+                for (unsigned dst : ends)
+                {
+                    if (graph->addSuccessor(src, dst, label))
+                        fresh.push_back(dst);
+                }
+            }
+            for (unsigned dst : fresh)
+            {
+                {
+                    std::lock_guard<std::mutex> guard(stripeOf(dst));
+                    graph->addPredecessor(src, dst, label);
+                }
+                queue(src, dst, label);
+            }
+        };
+        // Add src --label--> dst for each src in ends, and queue the new ones
+        auto addDerivedTo = [&](unsigned dst, EdgeLabel label) {
+            fresh.clear();
+            {
+                std::lock_guard<std::mutex> guard(stripeOf(dst));
+                for (unsigned src : ends)
+                {
+                    if (graph->addPredecessor(src, dst, label))
+                        fresh.push_back(src);
+                }
+            }
+            for (unsigned src : fresh)
+            {
+                {
+                    std::lock_guard<std::mutex> guard(stripeOf(src));
+                    graph->addSuccessor(src, dst, label);
+                }
+                queue(src, dst, label);
+            }
+        };
+        // Take a batch from the back of the own queue, or else half of another queue from its front
+        auto refill = [&]() {
+            {
+                std::lock_guard<std::mutex> guard(queues[self].lock);
+                std::deque<CFLREdge> &edges = queues[self].edges;
+                size_t num = std::min(edges.size(), HandOverBatch);
+                local.assign(edges.end() - num, edges.end());
+                edges.erase(edges.end() - num, edges.end());
+            }
+            for (unsigned i = 1; local.empty() && i < numThreads; ++i)
+            {
+                ThreadQueue &victim = queues[(self + i) % numThreads];
+                std::lock_guard<std::mutex> guard(victim.lock);
+                size_t num = (victim.edges.size() + 1) / 2;
+                local.assign(victim.edges.begin(), victim.edges.begin() + num);
+                victim.edges.erase(victim.edges.begin(), victim.edges.begin() + num);
+            }
+            return !local.empty();
+        };
+
+        while (true)
+        {
+            if (local.empty() && !refill())
+            {
+                // Idle: hand over whatever is batched, then wait for work or the end
+                bool flushed = false;
+                for (unsigned owner = 0; owner < numThreads; ++owner)
+                {
+                    if (!handOver[owner].empty())
+                    {
+                        flush(owner);
+                        flushed = true;
+                    }
+                }
+                if (flushed)
+                    continue;
+                if (pending == 0)
+                    break;
+                std::this_thread::yield();
+                continue;
+            }
+
+            CFLREdge edge = local.back();
+            local.pop_back();
+            for (const CFLGrammar::UnaryRule &rule : grammar.getUnaryRules(edge.label))
+            {
+                ends.assign(1, edge.dst);
+                addDerivedFrom(edge.src, rule.lhs);
+            }
+
+            // lhs ::= label other: extend the edge at its target
+            for (const CFLGrammar::BinaryRule &rule : grammar.getRulesByFirst(edge.label))
+            {
+                ends.clear();
+                {
+                    std::lock_guard<std::mutex> guard(stripeOf(edge.dst));
+                    graph->forEachSuccessor(edge.dst, rule.other, collect);
+                }
+                addDerivedFrom(edge.src, rule.lhs);
+            }
+
+            // lhs ::= other label: extend the edge at its source
+            for (const CFLGrammar::BinaryRule &rule : grammar.getRulesBySecond(edge.label))
+            {
+                ends.clear();
+                {
+                    std::lock_guard<std::mutex> guard(stripeOf(edge.src));
+                    graph->forEachPredecessor(edge.src, rule.other, collect);
+                }
+                addDerivedTo(edge.dst, rule.lhs);
+            }
+            --pending;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < numThreads; ++t)
+        threads.emplace_back(worker, t);
+    worker(0);
+    for (std::thread &thread : threads)
+        thread.join();
+}
@@ -0,0 +1,293 @@
+/**
+ * WorkList.h
+ * Edges of CFL-reachability, their packed keys and the worklist over them. Independent of SVF.
+ */
+
+#ifndef ANSWERS_WORKLIST_H
+#define ANSWERS_WORKLIST_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using EdgeLabel = unsigned;
+
+
+/**
+ * The edge type of CFL-reachability
+ */
+struct CFLREdge
+{
+    unsigned src;   // source
+    unsigned dst;   // target
+    EdgeLabel label;
+
+    CFLREdge(unsigned src, unsigned dst, EdgeLabel lbl) :
+            src(src), dst(dst), label(lbl)
+    {}
+
+    inline bool operator<(const CFLREdge &rhs) const
+    {
+        if (src != rhs.src) return src < rhs.src;
+        if (dst != rhs.dst) return dst < rhs.dst;
+        return label < rhs.label;
+    }
+
+    inline bool operator==(const CFLREdge &rhs) const
+    {
+        return (src == rhs.src) && (dst == rhs.dst) && (label == rhs.label);
+    }
+
+    /// The edge packed into one integer: label in the top LabelBits, then source, then target
+    inline uint64_t getKey() const
+    {
+        assert(label < (1u << LabelBits) && src < (1u << SrcBits) && dst < (1u << DstBits) && "edge too wide to pack");
+        return (uint64_t) label << (SrcBits + DstBits) | (uint64_t) src << DstBits | dst;
+    }
+
+    static inline CFLREdge fromKey(uint64_t key)
+    {
+        return CFLREdge((key >> DstBits) & ((1u << SrcBits) - 1), key & ((1u << DstBits) - 1), key >> (SrcBits + DstBits));
+    }
+
+    /// Whether getKey holds every edge between nodes with IDs below numNodes
+    static inline bool fitsKey(unsigned numNodes)
+    { return numNodes <= (1u << SrcBits); }
+
+    static constexpr unsigned LabelBits = 5;
+    static constexpr unsigned SrcBits = 29;
+    static constexpr unsigned DstBits = 30;
+};
+
+
+/// Mix the bits of a packed edge key, so that nearby keys spread over the whole table
+inline uint64_t hashEdgeKey(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+
+template<>
+struct std::hash<CFLREdge>
+{
+    size_t operator()(const CFLREdge &edge) const
+    { return hashEdgeKey(edge.getKey()); }
+};
+
+/**
+ * A set of edges stored as packed keys in one open-addressing table with linear probing. Erasing
+ * shifts the following entries of the probe sequence back instead of leaving tombstones, so the
+ * worklist pattern of inserting and erasing every edge once does not degrade the table.
+ */
+class CFLREdgeSet
+{
+public:
+    inline bool empty() const
+    { return numKeys == 0; }
+
+    inline size_t size() const
+    { return numKeys; }
+
+    inline size_t count(const CFLREdge &edge) const
+    {
+        if (slots.empty())
+            return 0;
+        return slots[findSlot(edge.getKey())] != EmptyKey;
+    }
+
+    /// Insert an edge; the flag is false if the set had it already
+    inline std::pair<uint64_t, bool> insert(const CFLREdge &edge)
+    {
+        uint64_t key = edge.getKey();
+        if (2 * (numKeys + 1) > slots.size())
+            grow();
+        size_t slot = findSlot(key);
+        if (slots[slot] == key)
+            return {key, false};
+        slots[slot] = key;
+        ++numKeys;
+        return {key, true};
+    }
+
+    inline size_t erase(const CFLREdge &edge)
+    {
+        if (slots.empty())
+            return 0;
+        size_t hole = findSlot(edge.getKey());
+        if (slots[hole] == EmptyKey)
+            return 0;
+        // Move back each later entry of the run whose home slot does not lie after the hole
+        size_t mask = slots.size() - 1;
+        for (size_t next = (hole + 1) & mask; slots[next] != EmptyKey; next = (next + 1) & mask)
+        {
+            size_t home = hashEdgeKey(slots[next]) & mask;
+            bool stays = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+            if (stays)
+                continue;
+            slots[hole] = slots[next];
+            hole = next;
+        }
+        slots[hole] = EmptyKey;
+        --numKeys;
+        return 1;
+    }
+
+    inline void clear()
+    {
+        std::fill(slots.begin(), slots.end(), EmptyKey);
+        numKeys = 0;
+    }
+
+protected:
+    /// No edge packs to this: the largest label is never used
+    static constexpr uint64_t EmptyKey = ~0ull;
+    static constexpr size_t MinSlots = 64;
+
+    /// The slot holding key, or the empty slot where it would go
+    inline size_t findSlot(uint64_t key) const
+    {
+        size_t mask = slots.size() - 1;
+        size_t slot = hashEdgeKey(key) & mask;
+        while (slots[slot] != key && slots[slot] != EmptyKey)
+            slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    /// Double the table (kept at most half full)
+    inline void grow()
+    {
+        std::vector<uint64_t> old(std::max(MinSlots, 2 * slots.size()), EmptyKey);
+        old.swap(slots);
+        for (uint64_t key : old)
+        {
+            if (key != EmptyKey)
+                slots[findSlot(key)] = key;
+        }
+    }
+
+    std::vector<uint64_t> slots;
+    size_t numKeys = 0;
+};
+
+
+/**
+ * FIFO order: elements are popped in the order they were pushed
+ */
+template<class T>
+class FIFOOrder
+{
+public:
+    inline bool empty() const
+    { return data_list.empty(); }
+
+    inline void clear()
+    { data_list.clear(); }
+
+    inline void push(const T &data)
+    { data_list.push_back(data); }
+
+    inline T pop()
+    {
+        T data = data_list.front();
+        data_list.pop_front();
+        return data;
+    }
+
+protected:
+    std::deque<T> data_list;
+};
+
+
+/**
+ * LIFO order: the most recently pushed element is popped first
+ */
+template<class T>
+class LIFOOrder
+{
+public:
+    inline bool empty() const
+    { return data_list.empty(); }
+
+    inline void clear()
+    { data_list.clear(); }
+
+    inline void push(const T &data)
+    { data_list.push_back(data); }
+
+    inline T pop()
+    {
+        T data = data_list.back();
+        data_list.pop_back();
+        return data;
+    }
+
+protected:
+    std::vector<T> data_list;
+};
+
+
+/**
+ * Worklist without duplicates; the scheduling policy is given by Order (FIFO by default) and
+ * the duplicate check by Set
+ */
+template<class T, template<class> class Order = FIFOOrder, class Set = std::unordered_set<T>>
+class WorkList
+{
+public:
+    /// Check whether the worklist is empty.
+    inline bool empty() const
+    { return order.empty(); }
+
+    /// Clear the worklist
+    inline void clear()
+    {
+        order.clear();
+        data_set.clear();
+    }
+
+    /// Push a data into the work list.
+    inline bool push(const T &data)
+    {
+        if (this->data_set.insert(data).second)
+        {
+            this->order.push(data);
+            ++numPushes;
+            return true;
+        }
+        else
+            return false;
+    }
+
+    /// Pop the next data according to the scheduling order.
+    inline T pop()
+    {
+        assert(!this->empty() && "work list is empty");
+        T data = this->order.pop();
+        this->data_set.erase(data);
+        ++numPops;
+        return data;
+    }
+
+    inline uint64_t getNumPushes() const
+    { return numPushes; }
+
+    inline uint64_t getNumPops() const
+    { return numPops; }
+
+protected:
+    Set data_set;       ///< to avoid duplicate elements
+    Order<T> order;     ///< decides which element is popped next
+    uint64_t numPushes = 0;
+    uint64_t numPops = 0;
+};
+
+#endif //ANSWERS_WORKLIST_H
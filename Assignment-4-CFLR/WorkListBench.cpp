@@ -0,0 +1,172 @@
+/**
+ * WorkListBench.cpp
+ * Push/pop rate of the CFLR worklist with each duplicate check: std::unordered_set<CFLREdge> with
+ * the former hash of (src, dst) only, the same with the label-aware hash, and CFLREdgeSet.
+ *
+ * Edges come in groups that share (src, dst) and differ in their label, as the edges the grammar
+ * derives between the same two nodes do, and are pushed in random order. Each round pushes every
+ * edge twice (the second push is a rejected duplicate), pops them all, and then looks up every
+ * edge and as many absent ones in a set holding all edges.
+ */
+
+#include "WorkList.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct BenchOptions
+{
+    uint64_t edges = 2000000;       ///< edges pushed per round
+    unsigned nodes = 100000;        ///< node IDs are drawn from [0, nodes)
+    unsigned labels = 8;            ///< labels per (src, dst) pair, at most NumLabels
+    unsigned rounds = 3;            ///< the best round is reported
+    unsigned seed = 1;
+};
+
+/// The labels of EdgeLabelType
+const unsigned NumLabels = 22;
+
+/// Takes what the timed loops compute, so the compiler cannot drop them
+volatile uint64_t sink;
+
+/// The hash CFLREdge had before keys were packed: labels on one pair all collide
+struct PairHash
+{
+    size_t operator()(const CFLREdge &edge) const
+    { return ((uint64_t) edge.src << 32) | (uint64_t) edge.dst; }
+};
+
+struct Rates
+{
+    double pushPop = 0;     ///< pushes and pops per second, duplicates included
+    double lookup = 0;      ///< membership checks per second
+};
+
+bool parseArgs(int argc, char **argv, BenchOptions &opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string name = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (name == "-edges")
+            opts.edges = std::strtoull(value.c_str(), nullptr, 10);
+        else if (name == "-nodes")
+            opts.nodes = std::strtoul(value.c_str(), nullptr, 10);
+        else if (name == "-labels")
+            opts.labels = std::strtoul(value.c_str(), nullptr, 10);
+        else if (name == "-rounds")
+            opts.rounds = std::strtoul(value.c_str(), nullptr, 10);
+        else if (name == "-seed")
+            opts.seed = std::strtoul(value.c_str(), nullptr, 10);
+        else
+            return false;
+    }
+    return opts.edges > 0 && opts.nodes > 0 && opts.labels > 0 && opts.labels <= NumLabels && opts.rounds > 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<class Set>
+Rates measure(const std::vector<CFLREdge> &edges, const std::vector<CFLREdge> &absent, unsigned rounds)
+{
+    Rates best;
+    uint64_t checksum = 0;
+    for (unsigned round = 0; round < rounds; ++round)
+    {
+        WorkList<CFLREdge, FIFOOrder, Set> workList;
+        auto start = std::chrono::steady_clock::now();
+        for (const CFLREdge &edge : edges)
+        {
+            workList.push(edge);
+            workList.push(edge);
+        }
+        while (!workList.empty())
+            checksum += workList.pop().dst;
+        best.pushPop = std::max(best.pushPop, 3 * edges.size() / secondsSince(start));
+
+        Set set;
+        for (const CFLREdge &edge : edges)
+            set.insert(edge);
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < edges.size(); ++i)
+            checksum += set.count(edges[i]) + set.count(absent[i]);
+        best.lookup = std::max(best.lookup, 2 * edges.size() / secondsSince(start));
+    }
+    sink = checksum;
+    return best;
+}
+}
+
+
+int main(int argc, char **argv)
+{
+    BenchOptions opts;
+    if (!parseArgs(argc, argv, opts))
+    {
+        std::cerr << "usage: " << argv[0] << " [-edges=N] [-nodes=N] [-labels=1-" << NumLabels
+                  << "] [-rounds=N] [-seed=N]\n";
+        return 1;
+    }
+
+    // Distinct edges, grouped by pair; pairs only get labels below opts.labels, so the absent
+    // edges use the labels from there up to NumLabels
+    std::mt19937 rng(opts.seed);
+    std::uniform_int_distribution<unsigned> node(0, opts.nodes - 1);
+    std::vector<CFLREdge> edges;
+    std::vector<CFLREdge> absent;
+    CFLREdgeSet seen;
+    while (edges.size() < opts.edges)
+    {
+        unsigned src = node(rng);
+        unsigned dst = node(rng);
+        for (unsigned label = 0; label < opts.labels && edges.size() < opts.edges; ++label)
+        {
+            if (seen.insert(CFLREdge(src, dst, label)).second)
+            {
+                edges.emplace_back(src, dst, label);
+                absent.emplace_back(src, dst, opts.labels + label % (NumLabels - opts.labels + 1));
+            }
+        }
+    }
+    // The grammar derives the labels of a pair at different times, not one after another
+    std::vector<size_t> order(edges.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+    std::vector<CFLREdge> shuffled;
+    std::vector<CFLREdge> shuffledAbsent;
+    for (size_t i : order)
+    {
+        shuffled.push_back(edges[i]);
+        shuffledAbsent.push_back(absent[i]);
+    }
+    edges.swap(shuffled);
+    absent.swap(shuffledAbsent);
+
+    std::cout << "edges " << edges.size() << ", nodes " << opts.nodes << ", labels per pair " << opts.labels
+              << ", best of " << opts.rounds << " rounds\n";
+    std::cout << std::left << std::setw(36) << "duplicate check" << std::right << std::setw(18) << "push+pop/sec"
+              << std::setw(18) << "lookups/sec" << "\n";
+    auto report = [](const char *name, const Rates &rates) {
+        std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(18) << rates.pushPop << std::setw(18) << rates.lookup << "\n";
+    };
+    report("unordered_set, (src, dst) hash", measure<std::unordered_set<CFLREdge, PairHash>>(edges, absent, opts.rounds));
+    report("unordered_set, packed-key hash", measure<std::unordered_set<CFLREdge>>(edges, absent, opts.rounds));
+    report("CFLREdgeSet", measure<CFLREdgeSet>(edges, absent, opts.rounds));
+    return 0;
+}
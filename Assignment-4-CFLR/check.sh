@@ -0,0 +1,93 @@
+#!/usr/bin/env bash
+# Result checks of the CFL-reachability solver over the Test-Cases of this assignment and of
+# Assignment-5, run by ctest.
+#   check.sh <cflr> andersen <andersen>   the PT edges are the points-to sets of andersen -reorder,
+#                                         which numbers field objects as cflr does
+#   check.sh <cflr> backends              -cflr-solver=matrix writes the result of -cflr-solver=worklist
+#   check.sh <cflr> threads               the parallel worklist backend (-threads=2, 4, 8) writes the
+#                                         result of -threads=1
+# CLANG (default $LLVM_DIR/bin/clang, then clang) compiles the .c cases.
+set -euo pipefail
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+CFLR="$1"
+MODE="$2"
+CLANG="${CLANG:-${LLVM_DIR:-}/bin/clang}"
+if [ ! -x "$CLANG" ]; then
+  CLANG="clang"
+fi
+
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+failures=0
+
+# Compile the .c cases into $WORK/bc
+compile() {
+  mkdir -p "$WORK/bc"
+  for f in "$SCRIPT_DIR"/Test-Cases/*.c "$SCRIPT_DIR"/../Assignment-5-Andersen/Test-Cases/*.c; do
+    "$CLANG" -O0 -g -emit-llvm -c "$f" -o "$WORK/bc/$(basename "${f%.c}").bc"
+  done
+}
+
+# Run a binary with the given options on a copy of a bitcode file in $WORK/<run>, where the
+# result <name>.res.txt is written
+run() {
+  local dir="$WORK/$1" bin="$2" bc="$3"
+  shift 3
+  mkdir -p "$dir"
+  cp "$bc" "$dir/"
+  (cd "$dir" && "$bin" "$@" "$(basename "$bc")" > "$(basename "$bc").log" 2>&1) ||
+    { echo "FAIL: $(basename "$bin") $* on $(basename "$bc")"; cat "$dir/$(basename "$bc").log"; failures=$((failures + 1)); }
+}
+
+# Compare two files byte for byte
+same() {
+  if ! cmp -s "$1" "$2"; then
+    echo "FAIL: $2 differs from $1"
+    diff "$1" "$2" | head -n 20 || true
+    failures=$((failures + 1))
+  fi
+}
+
+case "$MODE" in
+andersen)
+  ANDERSEN="$3"
+  compile
+  for bc in "$WORK"/bc/*.bc; do
+    name="$(basename "$bc")"
+    run cflr "$CFLR" "$bc"
+    run andersen "$ANDERSEN" "$bc" -reorder
+    # "p<TAB>points to<TAB>o" and "p points to: {o, ..., }" as sorted "p o" pairs
+    awk -F'\t' '{ print $1, $3 }' "$WORK/cflr/$name.res.txt" | sort > "$WORK/cflr/$name.pairs"
+    awk '/^[0-9]/ { for (i = 4; i <= NF; i++) { o = $i; gsub(/[{},]/, "", o); if (o != "") print $1, o } }' \
+        "$WORK/andersen/$name.res.txt" | sort > "$WORK/andersen/$name.pairs"
+    same "$WORK/andersen/$name.pairs" "$WORK/cflr/$name.pairs"
+  done
+  ;;
+backends)
+  compile
+  for bc in "$WORK"/bc/*.bc; do
+    name="$(basename "$bc")"
+    run worklist "$CFLR" "$bc" -cflr-solver=worklist
+    run matrix "$CFLR" "$bc" -cflr-solver=matrix
+    same "$WORK/worklist/$name.res.txt" "$WORK/matrix/$name.res.txt"
+  done
+  ;;
+threads)
+  compile
+  for bc in "$WORK"/bc/*.bc; do
+    name="$(basename "$bc")"
+    run threads1 "$CFLR" "$bc" -cflr-solver=worklist -threads=1
+    for threads in 2 4 8; do
+      run "threads$threads" "$CFLR" "$bc" -cflr-solver=worklist -threads=$threads
+      same "$WORK/threads1/$name.res.txt" "$WORK/threads$threads/$name.res.txt"
+    done
+  done
+  ;;
+*)
+  echo "usage: $0 <cflr> andersen <andersen> | backends | threads"
+  exit 2
+  ;;
+esac
+
+[ "$failures" -eq 0 ] || { echo "$failures check(s) failed"; exit 1; }
+echo "all checks passed"
@@ -7,54 +7,451 @@
 #define ANSWERS_A5HEADER_H
 
 #include "SVF-LLVM/SVFIRBuilder.h"
+#include "ConstraintCSR.h"
+#include "PointsTo.h"
+#include "SolverStats.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <tuple>
+#include <type_traits>
 
-/// Point-to set
-using PTS = std::map<unsigned, std::set<unsigned>>;
+/// Point-to set of a single pointer
+using PointsToSet = SparseBitmap;
+/// Point-to sets of all pointers
+#ifdef A5_SHARED_PTS
+using PTS = PersistentPtsMap<PointsToSet>;
+#else
+using PTS = DensePtsMap<PointsToSet>;
+#endif
 
 /**
- * FIFO worklist
+ * FIFO order: elements are popped in the order they were pushed
  */
 template<class T>
+class FIFOOrder
+{
+public:
+    inline bool empty() const
+    { return data_list.empty(); }
+
+    inline void clear()
+    { data_list.clear(); }
+
+    inline void push(const T &data)
+    { data_list.push_back(data); }
+
+    inline T pop()
+    {
+        T data = data_list.front();
+        data_list.pop_front();
+        return data;
+    }
+
+protected:
+    std::deque<T> data_list;
+};
+
+
+/**
+ * LIFO order: the most recently pushed element is popped first
+ */
+template<class T>
+class LIFOOrder
+{
+public:
+    inline bool empty() const
+    { return data_list.empty(); }
+
+    inline void clear()
+    { data_list.clear(); }
+
+    inline void push(const T &data)
+    { data_list.push_back(data); }
+
+    inline T pop()
+    {
+        T data = data_list.back();
+        data_list.pop_back();
+        return data;
+    }
+
+protected:
+    std::vector<T> data_list;
+};
+
+
+/**
+ * Topological (wave) order over node IDs: elements are popped by ascending rank in sweeps.
+ * An element pushed with a rank not above the one being processed waits for the next sweep.
+ * Ranks are set with setRanks; IDs without a rank go last.
+ */
+template<class T>
+class TopoOrder
+{
+    static_assert(std::is_integral<T>::value, "TopoOrder needs integral IDs");
+
+public:
+    inline bool empty() const
+    { return heap.empty(); }
+
+    inline void clear()
+    {
+        heap.clear();
+        curEpoch = curRank = 0;
+    }
+
+    inline void setRanks(std::vector<unsigned> r)
+    { ranks = std::move(r); }
+
+    inline void push(const T &data)
+    {
+        unsigned rank = (size_t) data < ranks.size() ? ranks[data] : ~0u;
+        unsigned epoch = rank > curRank ? curEpoch : curEpoch + 1;
+        heap.push_back({epoch, rank, seq++, data});
+        std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    }
+
+    inline T pop()
+    {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        Entry top = heap.back();
+        heap.pop_back();
+        curEpoch = std::get<0>(top);
+        curRank = std::get<1>(top);
+        return std::get<3>(top);
+    }
+
+protected:
+    using Entry = std::tuple<unsigned, unsigned, uint64_t, T>;   ///< (sweep, rank, push order, data)
+    std::vector<Entry> heap;
+    std::vector<unsigned> ranks;
+    unsigned curEpoch = 0;
+    unsigned curRank = 0;
+    uint64_t seq = 0;
+};
+
+
+/**
+ * Least-recently-fired order over node IDs: the element whose last pop is the oldest goes first;
+ * elements never popped before go first of all, in push order.
+ */
+template<class T>
+class LRFOrder
+{
+    static_assert(std::is_integral<T>::value, "LRFOrder needs integral IDs");
+
+public:
+    inline bool empty() const
+    { return heap.empty(); }
+
+    inline void clear()
+    { heap.clear(); }
+
+    inline void push(const T &data)
+    {
+        uint64_t fired = (size_t) data < lastFired.size() ? lastFired[data] : 0;
+        heap.push_back({fired, seq++, data});
+        std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    }
+
+    inline T pop()
+    {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        T data = std::get<2>(heap.back());
+        heap.pop_back();
+        if ((size_t) data >= lastFired.size())
+            lastFired.resize((size_t) data + 1, 0);
+        lastFired[data] = ++clock;
+        return data;
+    }
+
+protected:
+    using Entry = std::tuple<uint64_t, uint64_t, T>;    ///< (last fired, push order, data)
+    std::vector<Entry> heap;
+    std::vector<uint64_t> lastFired;
+    uint64_t clock = 0;
+    uint64_t seq = 0;
+};
+
+
+/**
+ * Worklist without duplicates; the scheduling policy is given by Order (FIFO by default)
+ */
+template<class T, template<class> class Order = FIFOOrder>
 class WorkList
 {
 public:
     /// Check whether the worklist is empty.
     inline bool empty() const
-    { return data_list.empty(); }
+    { return order.empty(); }
 
     /// Clear the worklist
     inline void clear()
     {
-        data_list.clear();
+        order.clear();
         data_set.clear();
     }
 
-    /// Push a data into the END work list.
+    /// Push a data into the work list.
     inline bool push(const T &data)
     {
         if (this->data_set.find(data) == data_set.end())
         {
-            this->data_list.push_back(data);
+            this->order.push(data);
             this->data_set.insert(data);
+            ++numPushes;
             return true;
         }
         else
             return false;
     }
 
-    /// Pop a data from the FRONT of work list.
+    /// Push a range of data, in order.
+    template<class Iter>
+    inline void pushAll(Iter begin, Iter end)
+    {
+        for (; begin != end; ++begin)
+            push(*begin);
+    }
+
+    /// Pop the next data according to the scheduling order.
     inline T pop()
     {
         assert(!this->empty() && "work list is empty");
-        T data = this->data_list.front();
-        this->data_list.pop_front();
+        T data = this->order.pop();
         this->data_set.erase(data);
+        ++numPops;
         return data;
     }
 
+    /// The scheduling order, e.g. to hand it node ranks
+    inline Order<T> &getOrder()
+    { return order; }
+
+    inline uint64_t getNumPushes() const
+    { return numPushes; }
+
+    inline uint64_t getNumPops() const
+    { return numPops; }
+
 protected:
     std::unordered_set<T> data_set;       ///< to avoid duplicate elements
-    std::deque<T> data_list;     ///< to access the elements at both the beginning and the end
+    Order<T> order;     ///< decides which element is popped next
+    uint64_t numPushes = 0;
+    uint64_t numPops = 0;
+};
+
+
+/**
+ * FIFO worklist over dense integral IDs: a ring buffer plus an in-queue bit per ID.
+ * Push and pop do no hashing, and once the buffer and the bits have grown to the
+ * number of IDs in use nothing is allocated any more.
+ */
+template<class T>
+class DenseWorkList
+{
+    static_assert(std::is_integral<T>::value, "DenseWorkList needs integral IDs");
+
+public:
+    /// Check whether the worklist is empty.
+    inline bool empty() const
+    { return count == 0; }
+
+    /// Clear the worklist
+    inline void clear()
+    {
+        while (!empty())
+            pop();
+    }
+
+    /// Size the buffer and the in-queue bits for IDs below n.
+    inline void reserve(size_t n)
+    {
+        if (inQueue.size() < n)
+            inQueue.resize(n, false);
+        if (ring.size() < n)
+            grow(n);
+    }
+
+    /// Push a data into the END of the work list.
+    inline bool push(const T &data)
+    {
+        size_t id = (size_t) data;
+        if (id >= inQueue.size())
+            inQueue.resize(std::max(id + 1, inQueue.size() * 2), false);
+        if (inQueue[id])
+            return false;
+        inQueue[id] = true;
+        if (count == ring.size())
+            grow(count + 1);
+        ring[(head + count) & (ring.size() - 1)] = data;
+        ++count;
+        ++numPushes;
+        return true;
+    }
+
+    /// Push a range of data, in order.
+    template<class Iter>
+    inline void pushAll(Iter begin, Iter end)
+    {
+        for (; begin != end; ++begin)
+            push(*begin);
+    }
+
+    /// Pop a data from the FRONT of the work list.
+    inline T pop()
+    {
+        assert(!this->empty() && "work list is empty");
+        T data = ring[head];
+        head = (head + 1) & (ring.size() - 1);
+        --count;
+        inQueue[(size_t) data] = false;
+        ++numPops;
+        return data;
+    }
+
+    inline uint64_t getNumPushes() const
+    { return numPushes; }
+
+    inline uint64_t getNumPops() const
+    { return numPops; }
+
+protected:
+    /// Reallocate the ring to a power of two of at least n slots, unwrapping the queue
+    void grow(size_t n)
+    {
+        size_t cap = ring.empty() ? 16 : ring.size();
+        while (cap < n)
+            cap *= 2;
+        std::vector<T> bigger(cap);
+        for (size_t i = 0; i < count; ++i)
+            bigger[i] = ring[(head + i) & (ring.size() - 1)];
+        ring.swap(bigger);
+        head = 0;
+    }
+
+    std::vector<T> ring;        ///< capacity is a power of two
+    std::vector<bool> inQueue;  ///< to avoid duplicate elements
+    size_t head = 0;
+    size_t count = 0;
+    uint64_t numPushes = 0;
+    uint64_t numPops = 0;
+};
+
+
+/**
+ * Memo of the field objects derived by gep edges.
+ * The field object of (object, constant offset) never changes once created, so each pair is
+ * resolved through the constraint graph only once. Variant geps map an object to its
+ * field-insensitive object and are kept in a flat array indexed by object.
+ */
+class FieldObjCache
+{
+public:
+    /// Field object the gep edge derives from o
+    inline SVF::NodeID get(SVF::ConstraintGraph *consg, SVF::NodeID o, const GepRef &gep)
+    {
+        if (gep.variant)
+        {
+            if (o < fiObjs.size() && fiObjs[o] != Unknown)
+            {
+                ++numHits;
+                return fiObjs[o];
+            }
+            ++numMisses;
+            SVF::NodeID fiObj = consg->getGepObjVar(o, gep.edge);
+            insert(o, gep.offset, true, fiObj);
+            return fiObj;
+        }
+
+        // Offsets that do not fit the key are rare enough to always be resolved
+        if (gep.offset < 0 || gep.offset > UINT32_MAX)
+        {
+            ++numMisses;
+            SVF::NodeID fieldObj = consg->getGepObjVar(o, gep.edge);
+            insert(o, gep.offset, false, fieldObj);
+            return fieldObj;
+        }
+        auto it = fieldObjs.find(((uint64_t) o << 32) | (uint64_t) gep.offset);
+        if (it != fieldObjs.end())
+        {
+            ++numHits;
+            return it->second;
+        }
+        ++numMisses;
+        SVF::NodeID fieldObj = consg->getGepObjVar(o, gep.edge);
+        insert(o, gep.offset, false, fieldObj);
+        return fieldObj;
+    }
+
+    /// Whether the field object the gep edge derives from o has been resolved
+    inline bool has(SVF::NodeID o, const GepRef &gep) const
+    {
+        if (gep.variant)
+            return o < fiObjs.size() && fiObjs[o] != Unknown;
+        if (gep.offset < 0 || gep.offset > UINT32_MAX)
+            return false;
+        return fieldObjs.count(((uint64_t) o << 32) | (uint64_t) gep.offset);
+    }
+
+    /// A resolved lookup; variant lookups have no offset
+    struct Resolution
+    {
+        SVF::NodeID obj;
+        SVF::APOffset offset;
+        bool variant;
+        SVF::NodeID fieldObj;
+    };
+
+    /// Record the field object of a lookup, e.g. one resolved in an earlier run
+    inline void insert(SVF::NodeID o, SVF::APOffset offset, bool variant, SVF::NodeID fieldObj)
+    {
+        if (variant)
+        {
+            if (o >= fiObjs.size())
+                fiObjs.resize(std::max<size_t>(o + 1, fiObjs.size() * 2), Unknown);
+            fiObjs[o] = fieldObj;
+        }
+        else if (offset >= 0 && offset <= UINT32_MAX)
+            fieldObjs.emplace(((uint64_t) o << 32) | (uint64_t) offset, fieldObj);
+        resolutions.push_back({o, variant ? 0 : offset, variant, fieldObj});
+    }
+
+    /// All lookups resolved so far, in the order the field objects were requested
+    inline const std::vector<Resolution> &getResolutions() const
+    { return resolutions; }
+
+    inline uint64_t getNumHits() const
+    { return numHits; }
+
+    inline uint64_t getNumMisses() const
+    { return numMisses; }
+
+private:
+    static constexpr SVF::NodeID Unknown = ~0u;
+
+    std::unordered_map<uint64_t, SVF::NodeID> fieldObjs;    ///< (object, offset) -> field object
+    std::vector<SVF::NodeID> fiObjs;    ///< object -> field-insensitive object of variant geps
+    std::vector<Resolution> resolutions;
+    uint64_t numHits = 0;
+    uint64_t numMisses = 0;
+};
+
+
+/// A constraint edge as persisted between runs; offset is the field index of normal geps
+struct StaticEdge
+{
+    uint32_t kind;
+    SVF::NodeID src;
+    SVF::NodeID dst;
+    int64_t offset;
+
+    inline bool operator<(const StaticEdge &rhs) const
+    { return std::tie(kind, src, dst, offset) < std::tie(rhs.kind, rhs.src, rhs.dst, rhs.offset); }
+
+    inline bool operator==(const StaticEdge &rhs) const
+    { return kind == rhs.kind && src == rhs.src && dst == rhs.dst && offset == rhs.offset; }
 };
 
 
@@ -62,6 +459,12 @@ protected:
 class Andersen
 {
 public:
+    /// Scheduling policies of the solver worklist
+    enum class WorkListPolicy
+    {
+        FIFO, LIFO, Topo, LRF
+    };
+
     explicit Andersen(SVF::ConstraintGraph *consg) :
             consg(consg)
     {}
@@ -70,10 +473,400 @@ public:
     void runPointerAnalysis();
     /// Dump results into a file
     void dumpResult();
+    /// Dump results into a memory-mappable binary file (see PtsFile.h)
+    void dumpBinaryResult();
+    /// Dump the solver statistics, the phase times and the peak RSS as JSON
+    void dumpStats();
+
+    inline void setWorkListPolicy(WorkListPolicy policy)
+    { wlPolicy = policy; }
+
+    /// Use the parallel solver with n threads when n > 1
+    inline void setNumThreads(unsigned n)
+    { numThreads = n ? n : 1; }
+
+    /// Let the solver reorder its work (difference propagation, lazy cycle detection, the offline
+    /// reduction, deferred field objects). Off, the plain FIFO solver runs and numbers field objects
+    /// in the order the reference solver creates them, unless a feature below needs the reordering one.
+    inline void setReorder(bool on)
+    { reorder = on; }
+
+    /// Whether runPointerAnalysis runs the plain FIFO solver
+    inline bool solvesInOrder() const
+    {
+        return !reorder && numThreads == 1 && wlPolicy == WorkListPolicy::FIFO && stateFile.empty() &&
+               !collapsesFields() && !memoryBudget && !timeBudget && !iterationBudget;
+    }
+
+    /// Merge pointer- and location-equivalent nodes offline before solving, when reordering
+    inline void setOfflineReduction(bool on)
+    { offlineReduction = on; }
+
+    /// Nodes and edges made redundant by the offline reduction
+    inline uint64_t getNumReducedNodes() const
+    { return numReducedNodes; }
+
+    inline uint64_t getNumReducedEdges() const
+    { return numReducedEdges; }
+
+    /// Persist the solved state to path and resume from it on the next run
+    inline void setStateFile(const std::string &path)
+    { stateFile = path; }
+
+    /// Recompute from scratch when more than this fraction of the nodes would be invalidated
+    inline void setMaxInvalidation(double fraction)
+    { maxInvalidation = fraction; }
+
+    /// Collapse a base object to a single field-insensitive object once more than n field objects
+    /// have been derived from it; 0 means no limit
+    inline void setFieldLimit(unsigned n)
+    { fieldLimit = n; }
+
+    /// Collapse the objects whose fields are derived along positive-weight cycles, i.e. cycles
+    /// of copy and gep edges that go through at least one gep edge
+    inline void setCollapsePWC(bool on)
+    { collapsePWC = on; }
+
+    /// Base objects made field-insensitive, and field objects merged into them
+    inline uint64_t getNumCollapsedObjs() const
+    { return collapsedBases.size(); }
+
+    inline uint64_t getNumCollapsedFields() const
+    { return numCollapsedFields; }
+
+    /// Precision given up to stay within the memory budget, in the order the stages are taken
+    enum DegradeStage
+    {
+        NotDegraded, FieldsMerged, SetsSummarised, Unified
+    };
+
+    /// Degrade precision in stages when the points-to storage nears bytes (0: no budget)
+    inline void setMemoryBudget(size_t bytes)
+    { memoryBudget = bytes; }
+
+    inline DegradeStage getDegradeStage() const
+    { return degradeStage; }
+
+    /// Dump the nodes degraded to stay within the memory budget into a file
+    void dumpDegraded();
+
+    /// Stop solving after this many seconds of wall-clock time (0: no budget). The sets are then
+    /// partial; the state file keeps the pending work so the next run resumes it.
+    inline void setTimeBudget(double seconds)
+    { timeBudget = seconds; }
+
+    /// Stop solving after this many worklist pops (0: no budget); see setTimeBudget
+    inline void setIterationBudget(uint64_t pops)
+    { iterationBudget = pops; }
+
+    /// Whether the last run reached the fixpoint before its budget expired
+    inline bool isComplete() const
+    { return !budgetExpired; }
+
+    /// Whether the set of n may still grow, after a run that stopped early
+    inline bool isInFlight(SVF::NodeID n) const
+    { return n < inFlight.size() && inFlight[n]; }
+
+    /// Representatives whose deltas were not processed when the budget expired, in worklist order
+    inline const std::vector<SVF::NodeID> &getPendingNodes() const
+    { return pendingNodes; }
+
+    /// How the last run used the persisted state
+    inline const std::string &getResumeSummary() const
+    { return resumeSummary; }
+
+    /// Parse a policy name (fifo, lifo, topo, lrf), returns false if unknown
+    static bool parseWorkListPolicy(const std::string &name, WorkListPolicy &policy);
+
+    inline const FieldObjCache &getFieldCache() const
+    { return fieldCache; }
+
+    /// Worklist pushes and pops of the last run
+    inline uint64_t getNumPushes() const
+    { return numPushes; }
+
+    inline uint64_t getNumPops() const
+    { return numPops; }
+
+    /// Points-to set of n, solving only the part of the constraint graph it depends on.
+    /// Results are memoised across queries; the reference is valid until the next query.
+    /// Queries are an alternative to runPointerAnalysis, not to be mixed with it.
+    const PointsToSet &pointsTo(SVF::NodeID n);
+    /// Points-to sets of several nodes, solved together
+    std::vector<PointsToSet> pointsTo(const std::vector<SVF::NodeID> &nodes);
+    /// Dump the points-to sets of the queried nodes into a file
+    void dumpQueries(const std::vector<SVF::NodeID> &nodes);
+
+    /// Counters and phase times; callers may add phases of their own
+    inline SolverStats &getStats()
+    { return stats; }
+
+    /// The points-to set of n as reported, with location classes expanded (may use scratch)
+    const PointsToSet &getExpandedPts(SVF::NodeID n, PointsToSet &scratch);
+
+    /// One more than the largest node ID that may have a solved set
+    inline SVF::NodeID getNumSolvedIds() const
+    { return std::max(pts.size(), repOf.size()); }
+
+    /// Node whose set n shares once cycles and equivalent pointers are merged (n if it was not merged)
+    inline SVF::NodeID getSetOwner(SVF::NodeID n)
+    { return getRep(n); }
+
+    /// Nodes the queries so far have explored
+    inline uint64_t getNumDemandedNodes() const
+    { return numDemanded; }
 
 protected:
+    /// Seed the points-to sets from Addr edges, collecting the nodes that got objects
+    void initAddrEdges(std::vector<SVF::NodeID> &initial);
+    /// The plain FIFO solver: whole sets along every edge, field objects created as they are met
+    void solveInOrder();
+    /// Run the solver loop from the initial nodes with the chosen worklist policy
+    void solveSequential(const std::vector<SVF::NodeID> &initial);
+    /// The solver loop, run over a worklist with the chosen scheduling policy
+    template<class WorkListT>
+    void solve(WorkListT &worklist, const std::vector<SVF::NodeID> &initial);
+    /// SCCs over the edges whose kind bit is in kindMask, numbered in reverse topological order;
+    /// returns the number of SCCs
+    unsigned computeSCCs(unsigned kindMask, std::vector<unsigned> &sccOf);
+    /// Topological rank of each node in the SCC condensation of the constraint graph
+    void computeTopoRanks(std::vector<unsigned> &ranks);
+    /// Offline HVN/HU: merge pointers with equal points-to sets and objects that are always pointed-to together
+    void reduceOffline();
+    /// The Addr, copy, load, store and gep edges of the graph as built, sorted
+    void collectStaticEdges(std::vector<StaticEdge> &edges);
+    /// Restore the state of the previous run and seed the nodes affected by the edge changes;
+    /// returns false, leaving the solver state untouched, if there is no usable state
+    bool resumeFromState(const std::vector<StaticEdge> &edges, std::vector<SVF::NodeID> &initial);
+    /// Write the solved state for the next run
+    void saveState(const std::vector<StaticEdge> &edges);
+    /// The round-based solver used with more than one thread
+    void solveParallel(const std::vector<SVF::NodeID> &initial);
+    /// Solve the points-to sets of nodes and of everything they depend on
+    void solveDemand(const std::vector<SVF::NodeID> &nodes);
+    /// Mark n and its backward-reachable predecessors as demanded and seed them; pointee tells
+    /// that n is an object some pointer points to
+    void demand(SVF::NodeID n, bool pointee, DenseWorkList<SVF::NodeID> &worklist);
+
+    inline bool isDemanded(SVF::NodeID n) const
+    { return n < demanded.size() && demanded[n]; }
+
+    /// A contiguous range of node IDs
+    struct NodeRange
+    {
+        const SVF::NodeID *first;
+        const SVF::NodeID *last;
+
+        inline const SVF::NodeID *begin() const
+        { return first; }
+
+        inline const SVF::NodeID *end() const
+        { return last; }
+
+        inline size_t size() const
+        { return last - first; }
+    };
+
+    /// Representative of the collapsed cycle the node belongs to
+    inline SVF::NodeID getRep(SVF::NodeID n)
+    {
+        if (n >= repOf.size())
+            return n;
+        SVF::NodeID root = n;
+        while (repOf[root] != root)
+            root = repOf[root];
+        // Path compression
+        while (repOf[n] != root)
+        {
+            SVF::NodeID next = repOf[n];
+            repOf[n] = root;
+            n = next;
+        }
+        return root;
+    }
+
+    /// Original nodes represented by rep (including rep itself)
+    inline NodeRange getMembers(const SVF::NodeID &rep) const
+    {
+        auto it = sccMembers.find(rep);
+        if (it == sccMembers.end())
+            return {&rep, &rep + 1};
+        return {it->second.data(), it->second.data() + it->second.size()};
+    }
+
+    /// Object standing for the location-equivalence class of o in points-to sets
+    inline SVF::NodeID getLocRep(SVF::NodeID o) const
+    { return o < locRepOf.size() ? locRepOf[o] : o; }
+
+    /// Objects represented by the location representative o (including o itself)
+    inline NodeRange getLocMembers(const SVF::NodeID &o) const
+    {
+        auto it = locMembers.find(o);
+        if (it == locMembers.end())
+            return {&o, &o + 1};
+        return {it->second.data(), it->second.data() + it->second.size()};
+    }
+
+    /// Mark the pointers the result lists even if their set is empty
+    void collectReported(std::vector<bool> &reported);
+    /// Add the field objects the gep edge derives from o to fieldObjs
+    inline void addFieldObjs(SVF::NodeID o, const GepRef &gep, PointsToSet &fieldObjs)
+    {
+        for (SVF::NodeID obj : getLocMembers(o))
+            fieldObjs.set(getLocRep(getFieldObj(obj, gep)));
+    }
+
+    /// addFieldObjs for the reordering solver loops: a lookup that would create a field object is
+    /// deferred to resolveFieldObjs, so that field objects get the same IDs whatever order the nodes
+    /// are visited in (solveInOrder creates them as it meets them instead)
+    inline void addKnownFieldObjs(SVF::NodeID o, const GepRef &gep, PointsToSet &fieldObjs)
+    {
+        for (SVF::NodeID obj : getLocMembers(o))
+        {
+            if (gep.variant || fieldCache.has(obj, gep) ||
+                (collapsesFields() && collapsedBases.count(consg->getFIObjVar(obj))))
+                fieldObjs.set(getLocRep(getFieldObj(obj, gep)));
+            else
+                pendingFieldObjs.push_back({obj, &gep});
+        }
+    }
+
+    /// Create the field objects deferred by addKnownFieldObjs, in (object, offset) order, and add
+    /// them to the gep targets; reps whose sets changed go to changed. Called once the sets are
+    /// stable otherwise, when the set of lookups is the same for every reordering solver.
+    void resolveFieldObjs(std::vector<SVF::NodeID> &changed);
+
+    /// Whether field objects may be collapsed into their base object while solving
+    inline bool collapsesFields() const
+    { return fieldLimit || collapsePWC || collapseAllFields; }
+
+    /// Field object the gep edge derives from obj, or the base object once that is collapsed
+    inline SVF::NodeID getFieldObj(SVF::NodeID obj, const GepRef &gep)
+    { return collapsesFields() ? getBoundedFieldObj(obj, gep) : fieldCache.get(consg, obj, gep); }
+
+    /// getFieldObj with collapsing: a PWC edge or one field object too many collapses the base
+    SVF::NodeID getBoundedFieldObj(SVF::NodeID obj, const GepRef &gep);
+    /// Mark the gep edges that lie on a cycle of copy and gep edges in the static graph
+    void detectPWCs();
+    /// Merge the field objects of the bases collapsed since the last call into their base and
+    /// replace them by the base in all points-to sets; reps whose sets changed go to changed
+    void applyCollapses(std::vector<SVF::NodeID> &changed);
+    /// Replace each object of objs by replacement[o] in all points-to sets and deltas, keeping
+    /// the objects not in removable; reps that gained objects go to changed
+    void replaceObjects(const PointsToSet &objs, const std::unordered_map<SVF::NodeID, SVF::NodeID> &replacement,
+                        const PointsToSet &removable, std::vector<SVF::NodeID> &changed);
+
+    /// Whether the time or iteration budget has run out after pops worklist pops; the clock is
+    /// only read if checkClock is set
+    bool outOfBudget(uint64_t pops, bool checkClock);
+    /// Record the work left when the budget expired: the reps in order, then any other rep
+    /// with a pending delta; marks the pointers still in flight
+    void stopSolving(const std::vector<SVF::NodeID> &order);
+    /// Pointers whose sets may still change: everything the pending deltas can flow into
+    void markInFlight();
+
+    /// Bytes held by the points-to sets, the deltas and the objects handled per pointer
+    size_t getPtsMemory() const;
+    /// Called by the solvers every memoryCheckInterval nodes: degrade one stage further if the
+    /// storage is near the budget; reps whose sets changed go to changed. Returns true once the
+    /// unification pass has solved the program.
+    bool checkMemoryBudget(std::vector<SVF::NodeID> &changed);
+    /// Stage 1: collapse every object with field objects, and all objects from then on
+    void mergeAllFields(std::vector<SVF::NodeID> &changed);
+    /// Stage 2: merge the objects of the largest sets into one summary object
+    void summariseLargeSets(std::vector<SVF::NodeID> &changed);
+    /// Stage 3: replace the solution by a unification-based one over the whole graph
+    void unifyAll();
+
+    /// Add the objects not yet in pts(dst) to both pts(dst) and diffPts(dst), returns whether any was added
+    bool propagate(SVF::NodeID dst, const PointsToSet &objs);
+    /// Propagate the whole set of src to dst
+    bool propagate(SVF::NodeID dst, SVF::NodeID src);
+    /// Merge the representative n into rep
+    void mergeNodes(SVF::NodeID rep, SVF::NodeID n);
+    /// Collapse the copy cycles reachable from start; the representatives of collapsed cycles are appended to newReps
+    void collapseCycles(SVF::NodeID start, std::vector<SVF::NodeID> &newReps);
+    /// Copy successors of a representative (possibly stale entries that need getRep)
+    const std::vector<SVF::NodeID> &getCopySuccs(SVF::NodeID rep);
+    /// Add the copy edge src -> dst derived by a Load/Store rule to the graph, the snapshot and the cached
+    /// successors; returns false if it already existed
+    bool addDerivedCopyEdge(SVF::NodeID src, SVF::NodeID dst);
+    /// Lazy cycle detection: returns whether the copy edge src -> dst has not been used as a trigger before
+    bool shouldDetectCycle(SVF::NodeID src, SVF::NodeID dst);
+
+    /// Whether m is the pointer of a Load or Store constraint
+    inline bool hasComplexConstraints(SVF::NodeID m) const
+    { return !csr.getLoadSuccs(m).empty() || !csr.getStoreSrcs(m).empty(); }
+
+    /// The objects of delta the Load/Store constraints of m have not handled yet, which are
+    /// recorded as handled; merges re-push whole sets, and these must not retry old edges
+    inline const PointsToSet &getNewComplexObjs(SVF::NodeID m, const PointsToSet &delta, PointsToSet &fresh)
+    {
+        fresh = delta;
+        fresh.subtract(complexDone.getPts(m));
+        complexDone.unionPts(m, fresh);
+        return fresh;
+    }
+
+    /// Load/Store edge insertions of m saved by handling complexDelta instead of delta
+    inline uint64_t getNumSkippedInsertions(SVF::NodeID m, const PointsToSet &delta, const PointsToSet &complexDelta) const
+    {
+        return (uint64_t) (delta.size() - complexDelta.size()) *
+               (csr.getLoadSuccs(m).size() + csr.getStoreSrcs(m).size());
+    }
+
     SVF::ConstraintGraph *consg;
+    ConstraintCSR csr;      ///< flat copy of consg's edges for the solver loops
+    FieldObjCache fieldCache;
+    std::vector<std::pair<SVF::NodeID, const GepRef *>> pendingFieldObjs;  ///< lookups deferred by addKnownFieldObjs
+    WorkListPolicy wlPolicy = WorkListPolicy::FIFO;
+    unsigned numThreads = 1;
+    bool reorder = false;
+    bool offlineReduction = true;
+    uint64_t numReducedNodes = 0;
+    uint64_t numReducedEdges = 0;
+    std::string stateFile;
+    SVF::NodeID numStaticIds = 0;   ///< one more than the largest node ID before solving
+    double maxInvalidation = 0.25;
+    std::string resumeSummary;
+    uint64_t numPushes = 0;
+    uint64_t numPops = 0;
+    SolverStats stats;
+    unsigned fieldLimit = 0;
+    bool collapsePWC = false;
+    std::unordered_set<const SVF::GepCGEdge *> pwcEdges;   ///< gep edges on positive-weight cycles
+    std::unordered_map<SVF::NodeID, unsigned> numFieldObjs;    ///< field objects derived from each base so far
+    std::unordered_set<SVF::NodeID> trackedFields;     ///< field objects counted in numFieldObjs
+    std::unordered_set<SVF::NodeID> collapsedBases;
+    std::vector<SVF::NodeID> pendingCollapses;     ///< collapsed bases whose fields are not merged yet
+    uint64_t numCollapsedFields = 0;
+    double timeBudget = 0;
+    uint64_t iterationBudget = 0;
+    std::chrono::steady_clock::time_point deadline;
+    bool budgetExpired = false;
+    std::vector<SVF::NodeID> pendingNodes;
+    std::vector<bool> inFlight;
+    size_t memoryBudget = 0;
+    uint64_t memoryCheckInterval = 1024;
+    DegradeStage degradeStage = NotDegraded;
+    bool collapseAllFields = false;
+    std::vector<std::pair<SVF::NodeID, DegradeStage>> degradedNodes;
     PTS pts;
+    DensePtsMap<PointsToSet> diffPts;   ///< objects added to pts since the node was last processed
+    PointsToSet diffScratch;
+    DensePtsMap<PointsToSet> complexDone;   ///< objects the Load/Store constraints of each pointer have handled
+    std::vector<SVF::NodeID> repOf;    ///< union-find parent links; nodes beyond the end are their own rep
+    std::unordered_map<SVF::NodeID, std::vector<SVF::NodeID>> sccMembers;  ///< members of collapsed cycles
+    std::unordered_map<SVF::NodeID, std::vector<SVF::NodeID>> copySuccs;  ///< copy successors of representatives
+    std::unordered_set<uint64_t> lcdEdges;     ///< copy edges that already triggered cycle detection
+    std::vector<SVF::NodeID> locRepOf;     ///< location representative of each object
+    std::unordered_map<SVF::NodeID, std::vector<SVF::NodeID>> locMembers;  ///< members of location classes
+    bool demandReady = false;
+    std::vector<bool> demanded;    ///< nodes whose sets the queries depend on
+    uint64_t numDemanded = 0;
+    bool storesDemanded = false;
+    std::vector<SVF::NodeID> storePtrs;    ///< pointers p of q -Store-> p
+    std::unordered_map<SVF::NodeID, std::vector<SVF::NodeID>> pendingStores;  ///< store pointers reaching a node not yet demanded
 };
 
 
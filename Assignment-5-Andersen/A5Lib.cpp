@@ -4,6 +4,10 @@
  */
 
 #include "A5Header.h"
+#include "PtsFile.h"
+
+#include <map>
+#include <sys/resource.h>
 
 void Andersen::dumpResult()
 {
@@ -15,14 +19,239 @@ void Andersen::dumpResult()
         return;
     }
 
-    // Write S-edges
-    for (auto &pointerIt : pts)
+    std::vector<bool> reported;
+    collectReported(reported);
+
+    // A run stopped by its budget marks the sets that may still grow
+    if (!isComplete())
+        outFile << "# partial result: sets marked \"in flight\" may still grow\n";
+
+    // Write S-edges; members of collapsed cycles report the set of their representative
+    PointsToSet scratch;
+    for (SVF::NodeID pointer = 0; pointer < reported.size(); ++pointer)
+    {
+        const PointsToSet &ptsSet = getExpandedPts(pointer, scratch);
+        if (!reported[pointer] && ptsSet.empty())
+            continue;
+        outFile << pointer << " points to: {";
+        for (auto pointee : ptsSet)
+        {
+            outFile << pointee << ", ";
+        }
+        outFile << (isInFlight(pointer) ? "} in flight\n" : "}\n");
+    }
+}
+
+
+void Andersen::dumpBinaryResult()
+{
+    std::string fname = SVF::PAG::getPAG()->getModuleIdentifier() + ".res.bin";
+    std::ofstream outFile(fname, std::ios::out | std::ios::binary);
+    if (!outFile)
+    {
+        std::cout << "error opening " + fname + "!!\n";
+        return;
+    }
+
+    std::vector<bool> reported;
+    collectReported(reported);
+
+    // Sizes first for the index, then the sets in one pass; see PtsFile.h for the layout
+    PtsFileHeader header{PtsFileMagic, PtsFileVersion, (uint32_t) reported.size(), 0,
+                         isComplete() ? 0 : PtsFilePartial};
+    std::vector<uint64_t> index(header.numIds + 1, 0);
+    std::vector<uint64_t> reportedBits(ptsFileReportedWords(header.numIds), 0);
+    std::vector<uint64_t> inFlightBits(ptsFileReportedWords(header.numIds), 0);
+    PointsToSet scratch;
+    for (SVF::NodeID pointer = 0; pointer < header.numIds; ++pointer)
+    {
+        const PointsToSet &ptsSet = getExpandedPts(pointer, scratch);
+        index[pointer + 1] = index[pointer] + ptsSet.size();
+        if (reported[pointer] || !ptsSet.empty())
+            reportedBits[pointer / 64] |= 1ull << (pointer % 64);
+        if (isInFlight(pointer))
+            inFlightBits[pointer / 64] |= 1ull << (pointer % 64);
+    }
+    header.numObjs = index[header.numIds];
+    outFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    outFile.write(reinterpret_cast<const char *>(index.data()), index.size() * sizeof(uint64_t));
+    outFile.write(reinterpret_cast<const char *>(reportedBits.data()), reportedBits.size() * sizeof(uint64_t));
+    outFile.write(reinterpret_cast<const char *>(inFlightBits.data()), inFlightBits.size() * sizeof(uint64_t));
+
+    std::vector<uint32_t> objs;
+    for (SVF::NodeID pointer = 0; pointer < header.numIds; ++pointer)
+    {
+        objs.clear();
+        for (auto pointee : getExpandedPts(pointer, scratch))
+            objs.push_back(pointee);
+        outFile.write(reinterpret_cast<const char *>(objs.data()), objs.size() * sizeof(uint32_t));
+    }
+}
+
+
+void Andersen::dumpDegraded()
+{
+    std::string fname = SVF::PAG::getPAG()->getModuleIdentifier() + ".degraded.txt";
+    std::ofstream outFile(fname, std::ios::out);
+    if (!outFile)
+    {
+        std::cout << "error opening " + fname + "!!\n";
+        return;
+    }
+
+    // Each node once, with the last stage that degraded it
+    static const char *stageNames[] = {"none", "fields-merged", "sets-summarised", "unified"};
+    std::map<SVF::NodeID, DegradeStage> stages;
+    for (auto const& entry : degradedNodes)
+        stages[entry.first] = std::max(stages[entry.first], entry.second);
+    outFile << "# stage reached: " << stageNames[degradeStage] << "\n";
+    for (auto const& entry : stages)
+        outFile << entry.first << " " << stageNames[entry.second] << "\n";
+}
+
+
+void Andersen::dumpStats()
+{
+    std::string fname = SVF::PAG::getPAG()->getModuleIdentifier() + ".stats.json";
+    std::ofstream outFile(fname, std::ios::out);
+    if (!outFile)
+    {
+        std::cout << "error opening " + fname + "!!\n";
+        return;
+    }
+
+    // Sizes of the reported points-to sets in power-of-two buckets: {0}, {1}, [2, 3], [4, 7], ...
+    std::vector<bool> reported;
+    collectReported(reported);
+    std::vector<uint64_t> histogram;
+    uint64_t numPointers = 0;
+    uint64_t numFacts = 0;
+    PointsToSet scratch;
+    for (SVF::NodeID pointer = 0; pointer < reported.size(); ++pointer)
+    {
+        const PointsToSet &ptsSet = getExpandedPts(pointer, scratch);
+        if (!reported[pointer] && ptsSet.empty())
+            continue;
+        unsigned bucket = 0;
+        for (uint64_t size = ptsSet.size(); size; size >>= 1)
+            ++bucket;
+        if (histogram.size() <= bucket)
+            histogram.resize(bucket + 1, 0);
+        ++histogram[bucket];
+        ++numPointers;
+        numFacts += ptsSet.size();
+    }
+
+    // ru_maxrss is in KiB on Linux
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    outFile << "{\n";
+    outFile << "  \"phases\": {";
+    const char *sep = "";
+    for (auto const& phase : stats.getPhases())
+    {
+        outFile << sep << "\n    \"" << phase.first << "\": " << phase.second;
+        sep = ",";
+    }
+    outFile << "\n  },\n";
+    outFile << "  \"peak_rss_kib\": " << usage.ru_maxrss << ",\n";
+    outFile << "  \"nodes\": " << consg->getTotalNodeNum() << ",\n";
+    outFile << "  \"instrumented\": " << (SolverStats::Enabled ? "true" : "false") << ",\n";
+    if (SolverStats::Enabled)
+    {
+        outFile << "  \"rules\": {";
+        for (unsigned rule = 0; rule < SolverStats::NumRules; ++rule)
+        {
+            outFile << (rule ? "," : "") << "\n    \"" << SolverStats::getRuleName(rule) << "\": {\"firings\": "
+                    << stats.getFirings(rule) << ", \"new_facts\": " << stats.getNewFacts(rule) << "}";
+        }
+        outFile << "\n  },\n";
+        outFile << "  \"copy_edges_added\": " << stats.getNumCopyEdges() << ",\n";
+        outFile << "  \"copy_edge_insertions_avoided\": " << stats.getNumSkippedInsertions() << ",\n";
+        outFile << "  \"duplicate_copy_edges\": " << stats.getNumDuplicateEdges() << ",\n";
+    }
+    outFile << "  \"worklist\": {\"pushes\": " << numPushes << ", \"pops\": " << numPops << "},\n";
+    outFile << "  \"complete\": " << (isComplete() ? "true" : "false") << ",\n";
+    outFile << "  \"pending_nodes\": " << pendingNodes.size() << ",\n";
+    outFile << "  \"degrade_stage\": " << degradeStage << ",\n";
+    outFile << "  \"collapsed_objects\": {\"bases\": " << getNumCollapsedObjs() << ", \"fields\": " << numCollapsedFields << "},\n";
+    outFile << "  \"pointers\": " << numPointers << ",\n";
+    outFile << "  \"facts\": " << numFacts << ",\n";
+    outFile << "  \"pts_size_histogram\": [";
+    for (unsigned bucket = 0; bucket < histogram.size(); ++bucket)
+    {
+        uint64_t lo = bucket ? 1ull << (bucket - 1) : 0;
+        uint64_t hi = bucket ? (1ull << bucket) - 1 : 0;
+        outFile << (bucket ? "," : "") << "\n    {\"min\": " << lo << ", \"max\": " << hi
+                << ", \"pointers\": " << histogram[bucket] << "}";
+    }
+    outFile << "\n  ]\n}\n";
+}
+
+void Andersen::collectReported(std::vector<bool> &reported)
+{
+    // Pointers with an empty set are reported only if a derived copy edge starts from them
+    // (they were queued by the Load/Store rules) or they are a direct copy/gep target of such a node
+    reported.assign(std::max(pts.size(), repOf.size()), false);
+    for (SVF::NodeID n = 0; n < pts.size(); ++n)
+    {
+        if (!pts.hasEntry(n))
+            continue;
+        // A touched location representative stands for all objects of its class
+        for (SVF::NodeID obj : getLocMembers(n))
+            reported[obj] = true;
+        if (!pts.getPts(getRep(n)).empty() || !consg->hasConstraintNode(n))
+            continue;
+        for (auto edge : consg->getConstraintNode(n)->getOutEdges())
+        {
+            auto edgeKind = edge->getEdgeKind();
+            if (edgeKind == SVF::ConstraintEdge::Copy || edgeKind == SVF::ConstraintEdge::NormalGep ||
+                edgeKind == SVF::ConstraintEdge::VariantGep)
+            {
+                if (edge->getDstID() >= reported.size())
+                    reported.resize(edge->getDstID() + 1, false);
+                reported[edge->getDstID()] = true;
+            }
+        }
+    }
+}
+
+
+void Andersen::dumpQueries(const std::vector<SVF::NodeID> &nodes)
+{
+    std::string fname = SVF::PAG::getPAG()->getModuleIdentifier() + ".query.txt";
+    std::ofstream outFile(fname, std::ios::out);
+    if (!outFile)
+    {
+        std::cout << "error opening " + fname + "!!\n";
+        return;
+    }
+
+    std::vector<PointsToSet> answers = pointsTo(nodes);
+    for (size_t i = 0; i < nodes.size(); ++i)
     {
-        outFile << pointerIt.first << " points to: {";
-        for (auto pointee : pointerIt.second)
+        outFile << nodes[i] << " points to: {";
+        for (auto pointee : answers[i])
         {
             outFile << pointee << ", ";
         }
         outFile << "}\n";
     }
-}
\ No newline at end of file
+}
+
+
+const PointsToSet &Andersen::getExpandedPts(SVF::NodeID n, PointsToSet &scratch)
+{
+    const PointsToSet &ptsSet = pts.getPts(getRep(n));
+    if (locMembers.empty())
+        return ptsSet;
+    // Location representatives stand for all objects of their class
+    scratch.clear();
+    for (auto pointee : ptsSet)
+    {
+        for (SVF::NodeID obj : getLocMembers(pointee))
+            scratch.set(obj);
+    }
+    return scratch;
+}
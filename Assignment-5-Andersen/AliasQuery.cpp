@@ -0,0 +1,198 @@
+/**
+ * AliasQuery.cpp
+ * @author kisslune
+ */
+
+#include "AliasQuery.h"
+
+#include <fstream>
+#include <iterator>
+
+AliasQuery::AliasQuery(Andersen &andersen, size_t cacheCapacity) :
+        cacheCapacity(cacheCapacity)
+{
+    // One copy of each solved set, shared by all pointers merged into the same owner
+    SVF::NodeID numIds = andersen.getNumSolvedIds();
+    std::unordered_map<SVF::NodeID, uint32_t> setOfOwner;
+    PointsToSet scratch;
+    setOf.assign(numIds, NoSet);
+    for (SVF::NodeID n = 0; n < numIds; ++n)
+    {
+        SVF::NodeID owner = andersen.getSetOwner(n);
+        auto it = setOfOwner.find(owner);
+        if (it == setOfOwner.end())
+        {
+            const PointsToSet &ptsSet = andersen.getExpandedPts(n, scratch);
+            uint32_t id = NoSet;
+            if (!ptsSet.empty())
+            {
+                id = sets.size();
+                sets.push_back(ptsSet);
+            }
+            it = setOfOwner.emplace(owner, id).first;
+        }
+        setOf[n] = it->second;
+    }
+
+    // Set -> pointers
+    setRows.assign(sets.size() + 1, 0);
+    for (uint32_t id : setOf)
+    {
+        if (id != NoSet)
+            ++setRows[id + 1];
+    }
+    for (size_t s = 0; s < sets.size(); ++s)
+        setRows[s + 1] += setRows[s];
+    setPointers.resize(setRows[sets.size()]);
+    std::vector<uint32_t> next(setRows.begin(), setRows.end() - 1);
+    for (SVF::NodeID n = 0; n < numIds; ++n)
+    {
+        if (setOf[n] != NoSet)
+            setPointers[next[setOf[n]]++] = n;
+    }
+
+    // Object -> sets holding it
+    SVF::NodeID numObjs = 0;
+    for (const PointsToSet &ptsSet : sets)
+    {
+        for (auto o : ptsSet)
+            numObjs = std::max(numObjs, (SVF::NodeID) o + 1);
+    }
+    objRows.assign(numObjs + 1, 0);
+    for (const PointsToSet &ptsSet : sets)
+    {
+        for (auto o : ptsSet)
+            ++objRows[o + 1];
+    }
+    for (SVF::NodeID o = 0; o < numObjs; ++o)
+        objRows[o + 1] += objRows[o];
+    objSets.resize(objRows[numObjs]);
+    next.assign(objRows.begin(), objRows.end() - 1);
+    for (uint32_t s = 0; s < sets.size(); ++s)
+    {
+        for (auto o : sets[s])
+            objSets[next[o]++] = s;
+    }
+}
+
+
+bool AliasQuery::mayAlias(SVF::NodeID p, SVF::NodeID q)
+{
+    uint32_t a = getSetId(p);
+    uint32_t b = getSetId(q);
+    if (a == NoSet || b == NoSet)
+        return false;
+    if (a == b)
+        return true;
+
+    // Pairs are cached by set, so every pointer sharing a set benefits
+    uint64_t key = a < b ? ((uint64_t) a << 32) | b : ((uint64_t) b << 32) | a;
+    auto it = cache.find(key);
+    if (it != cache.end())
+    {
+        ++numHits;
+        lru.splice(lru.begin(), lru, it->second);
+        return it->second->second;
+    }
+    ++numMisses;
+    bool alias = sets[a].intersects(sets[b]);
+    if (cacheCapacity)
+    {
+        lru.emplace_front(key, alias);
+        cache.emplace(key, lru.begin());
+        if (lru.size() > cacheCapacity)
+        {
+            cache.erase(lru.back().first);
+            lru.pop_back();
+        }
+    }
+    return alias;
+}
+
+
+std::vector<SVF::NodeID> AliasQuery::getAliases(SVF::NodeID p) const
+{
+    std::vector<SVF::NodeID> aliases;
+    uint32_t a = getSetId(p);
+    if (a == NoSet)
+        return aliases;
+    std::vector<uint32_t> related;
+    for (auto o : sets[a])
+        related.insert(related.end(), objSets.begin() + objRows[o], objSets.begin() + objRows[o + 1]);
+    std::sort(related.begin(), related.end());
+    related.erase(std::unique(related.begin(), related.end()), related.end());
+    for (uint32_t s : related)
+        aliases.insert(aliases.end(), setPointers.begin() + setRows[s], setPointers.begin() + setRows[s + 1]);
+    std::sort(aliases.begin(), aliases.end());
+    return aliases;
+}
+
+
+std::vector<SVF::NodeID> AliasQuery::getPointersTo(SVF::NodeID o) const
+{
+    std::vector<SVF::NodeID> pointers;
+    if ((size_t) o + 1 >= objRows.size())
+        return pointers;
+    for (uint32_t i = objRows[o]; i < objRows[o + 1]; ++i)
+    {
+        uint32_t s = objSets[i];
+        pointers.insert(pointers.end(), setPointers.begin() + setRows[s], setPointers.begin() + setRows[s + 1]);
+    }
+    std::sort(pointers.begin(), pointers.end());
+    return pointers;
+}
+
+
+int64_t AliasQuery::answerFile(const std::string &inFile, const std::string &outFile)
+{
+    std::ifstream in(inFile, std::ios::binary);
+    std::ofstream out(outFile, std::ios::out | std::ios::binary);
+    if (!in || !out)
+        return -1;
+
+    // Read and parse the whole file in memory: batches run to millions of pairs
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::string buffer;
+    buffer.reserve(1 << 20);
+    const char *cur = data.data();
+    const char *end = cur + data.size();
+    auto skipLine = [&]() {
+        while (cur < end && *cur != '\n')
+            ++cur;
+    };
+    auto parseId = [&](SVF::NodeID &id) {
+        while (cur < end && (*cur == ' ' || *cur == '\t' || *cur == '\r'))
+            ++cur;
+        if (cur == end || *cur < '0' || *cur > '9')
+            return false;
+        id = 0;
+        while (cur < end && *cur >= '0' && *cur <= '9')
+            id = id * 10 + (*cur++ - '0');
+        return true;
+    };
+
+    int64_t numPairs = 0;
+    while (cur < end)
+    {
+        SVF::NodeID p, q;
+        if (parseId(p) && parseId(q))
+        {
+            buffer += std::to_string(p);
+            buffer += ' ';
+            buffer += std::to_string(q);
+            buffer += mayAlias(p, q) ? " MayAlias\n" : " NoAlias\n";
+            ++numPairs;
+            if (buffer.size() >= (1 << 20))
+            {
+                out.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+        // Anything else on the line, including '#' comments, is ignored
+        skipLine();
+        if (cur < end)
+            ++cur;
+    }
+    out.write(buffer.data(), buffer.size());
+    return numPairs;
+}
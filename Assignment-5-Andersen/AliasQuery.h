@@ -0,0 +1,64 @@
+/**
+ * AliasQuery.h
+ * Alias queries over the points-to sets solved by Andersen.
+ */
+
+#ifndef ANSWERS_ALIASQUERY_H
+#define ANSWERS_ALIASQUERY_H
+
+#include "A5Header.h"
+#include <list>
+
+/**
+ * Answers "may p and q alias?" and "what may alias p?" after solving.
+ * Pointers whose sets were merged share one copy of the set, so the inverted index maps each
+ * object to the distinct sets holding it and each set to its pointers. Pair results go through
+ * a small LRU cache, since clients tend to ask about the same pointers repeatedly.
+ */
+class AliasQuery
+{
+public:
+    /// Index the solved sets of andersen; cacheCapacity pairs are kept in the LRU cache
+    explicit AliasQuery(Andersen &andersen, size_t cacheCapacity = 1 << 16);
+
+    /// Whether the points-to sets of p and q share an object
+    bool mayAlias(SVF::NodeID p, SVF::NodeID q);
+
+    /// Pointers whose sets share an object with the set of p, sorted (p included if its set is non-empty)
+    std::vector<SVF::NodeID> getAliases(SVF::NodeID p) const;
+
+    /// Pointers that may point to o, sorted
+    std::vector<SVF::NodeID> getPointersTo(SVF::NodeID o) const;
+
+    /// Answer the "p q" pairs of inFile into outFile, one "p q MayAlias|NoAlias" line each;
+    /// returns the number of pairs answered, or -1 if a file cannot be opened
+    int64_t answerFile(const std::string &inFile, const std::string &outFile);
+
+    inline uint64_t getNumHits() const
+    { return numHits; }
+
+    inline uint64_t getNumMisses() const
+    { return numMisses; }
+
+private:
+    static constexpr uint32_t NoSet = ~0u;
+
+    /// The distinct set n points to, NoSet if it is empty
+    inline uint32_t getSetId(SVF::NodeID n) const
+    { return n < setOf.size() ? setOf[n] : NoSet; }
+
+    std::vector<uint32_t> setOf;        ///< pointer -> index into sets
+    std::vector<PointsToSet> sets;      ///< distinct non-empty solved sets
+    std::vector<uint32_t> setRows;      ///< set -> its pointers, as rows of setPointers
+    std::vector<SVF::NodeID> setPointers;
+    std::vector<uint32_t> objRows;      ///< object -> sets holding it, as rows of objSets
+    std::vector<uint32_t> objSets;
+
+    size_t cacheCapacity;
+    std::list<std::pair<uint64_t, bool>> lru;     ///< most recent pair first
+    std::unordered_map<uint64_t, std::list<std::pair<uint64_t, bool>>::iterator> cache;
+    uint64_t numHits = 0;
+    uint64_t numMisses = 0;
+};
+
+#endif //ANSWERS_ALIASQUERY_H
@@ -4,37 +4,449 @@
  */
 
 #include "A5Header.h"
+#include "AliasQuery.h"
+
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
 
 using namespace llvm;
 using namespace std;
 
+static Option<std::string> WorkListPolicyName(
+        "wl-policy",
+        "Scheduling policy of the solver worklist: fifo, lifo, topo or lrf",
+        "fifo");
+
+static Option<unsigned> NumThreads(
+        "threads",
+        "Number of solver threads; more than one runs the round-based parallel solver",
+        1);
+
+static Option<bool> Reorder(
+        "reorder",
+        "Solve with difference propagation, lazy cycle detection and deferred field objects; the sets "
+        "are the same, but field objects may be numbered differently from the plain FIFO solver. "
+        "Implied by -threads, -wl-policy other than fifo, -state-file, -field-limit, -pwc and the budgets",
+        false);
+
+static Option<bool> OfflineReduction(
+        "hvn",
+        "Merge pointer- and location-equivalent nodes (HVN/HU) before solving, when reordering",
+        true);
+
+static Option<std::string> StateFile(
+        "state-file",
+        "Persist the solved state to this file and re-analyse incrementally from it on the next run",
+        "");
+
+static Option<double> MaxInvalidation(
+        "max-invalidate",
+        "Fraction of the nodes above which edge deletions trigger a full re-analysis",
+        0.25);
+
+static Option<bool> PrintFieldCacheStats(
+        "field-cache-stats",
+        "Print the hits and misses of the field-object cache",
+        false);
+
+static Option<bool> PrintWorkListStats(
+        "wl-stats",
+        "Print the number of worklist pushes and pops",
+        false);
+
+static Option<std::string> QueryFile(
+        "query-file",
+        "Answer the points-to queries listed in this file (node IDs, '#' starts a comment) on demand "
+        "instead of solving the whole program",
+        "");
+
+static Option<bool> BinaryResult(
+        "binary-result",
+        "Write the result as a memory-mappable binary file (.res.bin, see ptsconvert) instead of text",
+        false);
+
+static Option<bool> DumpStats(
+        "stats",
+        "Write solver statistics, phase times and the peak RSS to <module>.stats.json "
+        "(rule counters need a build with A5_STATS)",
+        false);
+
+static Option<std::string> AliasQueryFile(
+        "alias-queries",
+        "After solving, answer the pointer pairs listed in this file (\"p q\" per line) into "
+        "<module>.alias.txt",
+        "");
+
+static Option<unsigned> AliasCacheSize(
+        "alias-cache",
+        "Number of pointer-pair results the alias queries keep in their LRU cache",
+        1 << 16);
+
+static Option<unsigned> FieldLimit(
+        "field-limit",
+        "Collapse an object to one field-insensitive object once more than this many field objects "
+        "are derived from it (0: no limit)",
+        0);
+
+static Option<bool> CollapsePWC(
+        "pwc",
+        "Collapse the objects whose fields are derived along positive-weight cycles (cycles through "
+        "gep edges) to field-insensitive objects",
+        false);
+
+static Option<unsigned> MemoryBudget(
+        "mem-budget",
+        "Points-to storage budget in MiB; near it the solver merges field objects, then summarises "
+        "large sets, then falls back to unification, listing the degraded nodes in "
+        "<module>.degraded.txt (0: no budget)",
+        0);
+
+static Option<double> TimeBudget(
+        "time-budget",
+        "Stop solving after this many seconds; the result marks the pointers still in flight and the "
+        "state file (<module>.checkpoint unless -state-file is given) lets the next run resume; there "
+        "is no checkpoint with -field-limit, -pwc or -mem-budget (0: no budget)",
+        0);
+
+static Option<unsigned> IterationBudget(
+        "iteration-budget",
+        "Stop solving after this many worklist pops, like -time-budget (0: no budget)",
+        0);
+
 int main(int argc, char** argv)
 {
     auto moduleNameVec =
             OptionBase::parseOptions(argc, argv, "Whole Program Points-to Analysis",
                                      "[options] <input-bitcode...>");
 
+    PhaseTimer timer;
     SVF::LLVMModuleSet::buildSVFModule(moduleNameVec);
+    double moduleTime = timer.lap();
 
     SVF::SVFIRBuilder builder;
     auto pag = builder.build();
+    double buildTime = timer.lap();
     auto consg = new SVF::ConstraintGraph(pag);
+    double consgTime = timer.lap();
     // consg->dump(); // Removed to prevent linker error
 
     Andersen andersen(consg);
+    Andersen::WorkListPolicy policy;
+    if (!Andersen::parseWorkListPolicy(WorkListPolicyName(), policy))
+    {
+        std::cerr << "unknown worklist policy '" << WorkListPolicyName() << "'\n";
+        return 1;
+    }
+    andersen.setWorkListPolicy(policy);
+    andersen.setNumThreads(NumThreads());
+    andersen.setReorder(Reorder());
+    andersen.setOfflineReduction(OfflineReduction());
+    // A budgeted run checkpoints, so that rerunning it continues where it stopped; the state file
+    // does not keep collapsed fields or degraded sets, so with those there is no checkpoint
+    bool collapses = FieldLimit() || CollapsePWC() || MemoryBudget();
+    bool budgeted = TimeBudget() > 0 || IterationBudget();
+    std::string stateFile = StateFile();
+    if (stateFile.empty() && budgeted && QueryFile().empty())
+    {
+        if (collapses)
+            std::cerr << "no checkpoint for a budgeted run with -field-limit, -pwc or -mem-budget: "
+                         "rerunning it starts over\n";
+        else
+            stateFile = pag->getModuleIdentifier() + ".checkpoint";
+    }
+    andersen.setStateFile(stateFile);
+    andersen.setMaxInvalidation(MaxInvalidation());
+    andersen.setTimeBudget(TimeBudget());
+    andersen.setIterationBudget(IterationBudget());
+    if (!stateFile.empty() && collapses)
+        std::cerr << "field collapsing and memory budgets are not supported with -state-file, ignored\n";
+    else if (QueryFile().empty())
+    {
+        andersen.setFieldLimit(FieldLimit());
+        andersen.setCollapsePWC(CollapsePWC());
+        andersen.setMemoryBudget((size_t) MemoryBudget() << 20);
+    }
+    andersen.getStats().addPhase("module-load", moduleTime);
+    andersen.getStats().addPhase("svfir-build", buildTime);
+    andersen.getStats().addPhase("constraint-graph", consgTime);
+
+    if (!QueryFile().empty())
+    {
+        std::ifstream queryFile(QueryFile());
+        if (!queryFile)
+        {
+            std::cerr << "cannot open query file '" << QueryFile() << "'\n";
+            return 1;
+        }
+        std::vector<SVF::NodeID> queries;
+        std::string line;
+        while (std::getline(queryFile, line))
+        {
+            std::istringstream fields(line.substr(0, line.find('#')));
+            SVF::NodeID n;
+            while (fields >> n)
+                queries.push_back(n);
+        }
+        timer.lap();
+        andersen.dumpQueries(queries);
+        andersen.getStats().addPhase("queries", timer.lap());
+        if (DumpStats())
+            andersen.dumpStats();
+        std::cout << "demand: " << andersen.getNumDemandedNodes() << " of " << consg->getTotalNodeNum()
+                  << " nodes explored for " << queries.size() << " queries\n";
+        SVF::LLVMModuleSet::releaseLLVMModuleSet();
+        return 0;
+    }
 
-    // TODO: complete the following method
+    SVF::u32_t numStaticNodes = consg->getTotalNodeNum();
+    timer.lap();
     andersen.runPointerAnalysis();
+    andersen.getStats().addPhase("pointer-analysis", timer.lap());
+    if (OfflineReduction() && !andersen.solvesInOrder())
+        std::cout << "offline reduction: " << andersen.getNumReducedNodes() << " of "
+                  << numStaticNodes << " nodes and " << andersen.getNumReducedEdges()
+                  << " edges eliminated\n";
+    if (!stateFile.empty() && !andersen.getResumeSummary().empty())
+        std::cout << "incremental: " << andersen.getResumeSummary() << "\n";
+    if (!andersen.isComplete())
+        std::cout << "budget: stopped before the fixpoint with " << andersen.getPendingNodes().size()
+                  << " nodes pending, "
+                  << (stateFile.empty() ? std::string("no checkpoint") : "checkpoint in " + stateFile) << "\n";
+    if (andersen.getDegradeStage() != Andersen::NotDegraded)
+    {
+        andersen.dumpDegraded();
+        static const char *stageNames[] = {"", "field objects merged", "large sets summarised",
+                                           "unification-based result"};
+        std::cout << "memory budget: degraded to stage " << andersen.getDegradeStage() << " ("
+                  << stageNames[andersen.getDegradeStage()] << ")\n";
+    }
+    if (andersen.getNumCollapsedObjs())
+        std::cout << "field collapsing: " << andersen.getNumCollapsedObjs() << " objects collapsed, "
+                  << andersen.getNumCollapsedFields() << " field objects merged\n";
+    if (PrintFieldCacheStats())
+        std::cout << "field-object cache: " << andersen.getFieldCache().getNumHits() << " hits, "
+                  << andersen.getFieldCache().getNumMisses() << " misses\n";
+    if (PrintWorkListStats())
+        std::cout << "worklist: " << andersen.getNumPushes() << " pushes, "
+                  << andersen.getNumPops() << " pops\n";
 
-    andersen.dumpResult();
+    if (BinaryResult())
+        andersen.dumpBinaryResult();
+    else
+        andersen.dumpResult();
+    andersen.getStats().addPhase("dump", timer.lap());
+    if (!AliasQueryFile().empty())
+    {
+        AliasQuery aliases(andersen, AliasCacheSize());
+        std::string outName = SVF::PAG::getPAG()->getModuleIdentifier() + ".alias.txt";
+        int64_t numPairs = aliases.answerFile(AliasQueryFile(), outName);
+        if (numPairs < 0)
+        {
+            std::cerr << "cannot answer alias queries from '" << AliasQueryFile() << "' into " << outName << "\n";
+            return 1;
+        }
+        andersen.getStats().addPhase("alias-queries", timer.lap());
+        std::cout << "alias: " << numPairs << " pairs, " << aliases.getNumHits() << " cache hits, "
+                  << aliases.getNumMisses() << " misses\n";
+    }
+    if (DumpStats())
+        andersen.dumpStats();
     SVF::LLVMModuleSet::releaseLLVMModuleSet();
 	return 0;
 }
 
 
+bool Andersen::parseWorkListPolicy(const std::string &name, WorkListPolicy &policy)
+{
+    if (name == "fifo")
+        policy = WorkListPolicy::FIFO;
+    else if (name == "lifo")
+        policy = WorkListPolicy::LIFO;
+    else if (name == "topo")
+        policy = WorkListPolicy::Topo;
+    else if (name == "lrf")
+        policy = WorkListPolicy::LRF;
+    else
+        return false;
+    return true;
+}
+
+
 void Andersen::runPointerAnalysis()
 {
-    WorkList<SVF::NodeID> worklist;
+    PhaseTimer timer;
+    if (solvesInOrder())
+    {
+        solveInOrder();
+        stats.addPhase("pointer-analysis.solve", timer.lap());
+        return;
+    }
+    deadline = std::chrono::steady_clock::now() +
+               std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timeBudget));
+    budgetExpired = false;
+    pendingNodes.clear();
+    csr.build(consg);
+    stats.addPhase("pointer-analysis.snapshot", timer.lap());
+
+    // Resume from the state of the previous run if there is one, otherwise start from the Addr edges
+    std::vector<StaticEdge> staticEdges;
+    std::vector<SVF::NodeID> initial;
+    bool resumed = false;
+    if (!stateFile.empty())
+    {
+        collectStaticEdges(staticEdges);
+        resumed = resumeFromState(staticEdges, initial);
+        stats.addPhase("pointer-analysis.resume", timer.lap());
+    }
+    if (!resumed)
+    {
+        if (offlineReduction)
+        {
+            reduceOffline();
+            stats.addPhase("pointer-analysis.offline-reduction", timer.lap());
+        }
+        initAddrEdges(initial);
+    }
+    memoryCheckInterval = std::max<uint64_t>(1024, csr.numNodes() / 4);
+    if (collapsePWC)
+    {
+        detectPWCs();
+        stats.addPhase("pointer-analysis.pwc-detection", timer.lap());
+    }
+
+    if (numThreads > 1)
+        solveParallel(initial);
+    else
+        solveSequential(initial);
+    stats.addPhase("pointer-analysis.solve", timer.lap());
+
+    if (!stateFile.empty())
+    {
+        saveState(staticEdges);
+        stats.addPhase("pointer-analysis.save-state", timer.lap());
+    }
+}
+
+
+void Andersen::solveSequential(const std::vector<SVF::NodeID> &initial)
+{
+    switch (wlPolicy)
+    {
+    case WorkListPolicy::FIFO:
+    {
+        DenseWorkList<SVF::NodeID> worklist;
+        worklist.reserve(consg->getTotalNodeNum());
+        solve(worklist, initial);
+        break;
+    }
+    case WorkListPolicy::LIFO:
+    {
+        WorkList<SVF::NodeID, LIFOOrder> worklist;
+        solve(worklist, initial);
+        break;
+    }
+    case WorkListPolicy::Topo:
+    {
+        WorkList<SVF::NodeID, TopoOrder> worklist;
+        std::vector<unsigned> ranks;
+        computeTopoRanks(ranks);
+        worklist.getOrder().setRanks(std::move(ranks));
+        solve(worklist, initial);
+        break;
+    }
+    case WorkListPolicy::LRF:
+    {
+        WorkList<SVF::NodeID, LRFOrder> worklist;
+        solve(worklist, initial);
+        break;
+    }
+    }
+}
+
+
+void Andersen::solveInOrder()
+{
+    // The order of this loop decides the IDs of the field objects, so it visits the nodes, edges
+    // and objects exactly as the reference solver does; see -reorder for the faster loop
+    DenseWorkList<SVF::NodeID> worklist;
+    worklist.reserve(consg->getTotalNodeNum());
+    pts.reserve(consg->getTotalNodeNum());
+
+    // Rule: o -Address-> p  =>  pts(p) = pts(p) U {o}
+    for (auto const& iter : *consg)
+    {
+        for (auto edge : iter.second->getOutEdges())
+        {
+            if (edge->getEdgeKind() == SVF::ConstraintEdge::Addr && pts.addPts(edge->getDstID(), edge->getSrcID()))
+                worklist.push(edge->getDstID());
+        }
+    }
+
+    PointsToSet fieldObjs;
+    while (!worklist.empty())
+    {
+        SVF::NodeID p = worklist.pop();
+        SVF::ConstraintNode* pNode = consg->getConstraintNode(p);
+        // Sets are fetched per rule: unionPts on a new node may reallocate the map
+        pts.touch(p);
+
+        // q -Store-> p  =>  q -Copy-> o
+        for (auto edge : pNode->getInEdges())
+        {
+            if (edge->getEdgeKind() != SVF::ConstraintEdge::Store)
+                continue;
+            A5_STAT(stats.fire(SolverStats::Store, pts.getPts(p).size()));
+            for (SVF::NodeID o : pts.getPts(p))
+            {
+                if (consg->addCopyCGEdge(edge->getSrcID(), o))
+                    worklist.push(edge->getSrcID());
+            }
+        }
+
+        for (auto edge : pNode->getOutEdges())
+        {
+            auto edgeKind = edge->getEdgeKind();
+            // Copy Rule: p -Copy-> x
+            if (edgeKind == SVF::ConstraintEdge::Copy)
+            {
+                A5_STAT(stats.fire(SolverStats::Copy));
+                if (pts.unionPts(edge->getDstID(), p))
+                    worklist.push(edge->getDstID());
+            }
+            // Load Rule: p -Load-> r  =>  o -Copy-> r
+            else if (edgeKind == SVF::ConstraintEdge::Load)
+            {
+                A5_STAT(stats.fire(SolverStats::Load, pts.getPts(p).size()));
+                for (SVF::NodeID o : pts.getPts(p))
+                {
+                    if (consg->addCopyCGEdge(o, edge->getDstID()))
+                        worklist.push(o);
+                }
+            }
+            // Gep Rule: p -Gep-> x
+            else if (auto gepEdge = llvm::dyn_cast<SVF::GepCGEdge>(edge))
+            {
+                A5_STAT(stats.fire(SolverStats::Gep, pts.getPts(p).size()));
+                fieldObjs.clear();
+                for (SVF::NodeID o : pts.getPts(p))
+                    fieldObjs.set(consg->getGepObjVar(o, gepEdge));
+                // Union after the loop: pts(x) may share storage with pts(p)
+                if (pts.unionPts(edge->getDstID(), fieldObjs))
+                    worklist.push(edge->getDstID());
+            }
+        }
+    }
+    numPushes = worklist.getNumPushes();
+    numPops = worklist.getNumPops();
+}
+
+
+void Andersen::initAddrEdges(std::vector<SVF::NodeID> &initial)
+{
+    pts.reserve(consg->getTotalNodeNum());
+    diffPts.reserve(consg->getTotalNodeNum());
 
     // -------------------------------------------------------
     // 1. Initialize WorkList (Processing Address Edges)
@@ -48,95 +460,750 @@ void Andersen::runPointerAnalysis()
             // Fix: Check directly to avoid type mismatch error
             if (edge->getEdgeKind() == SVF::ConstraintEdge::Addr)
             {
-                SVF::NodeID o = edge->getSrcID();
-                SVF::NodeID p = edge->getDstID();
-                if (pts[p].insert(o).second)
+                SVF::NodeID o = getLocRep(edge->getSrcID());
+                SVF::NodeID p = getRep(edge->getDstID());
+                A5_STAT(stats.fire(SolverStats::Addr));
+                if (pts.addPts(p, o))
                 {
-                    worklist.push(p);
+                    A5_STAT(stats.addFacts(SolverStats::Addr, 1));
+                    diffPts.addPts(p, o);
+                    initial.push_back(p);
                 }
             }
         }
     }
+}
+
+
+void Andersen::resolveFieldObjs(std::vector<SVF::NodeID> &changed)
+{
+    // The lookups pending once the sets are stable follow from the fixpoint alone, so creating
+    // the new field objects in (object, offset) order numbers them the same way in every
+    // reordering solver
+    std::sort(pendingFieldObjs.begin(), pendingFieldObjs.end(),
+              [](const std::pair<SVF::NodeID, const GepRef *> &a, const std::pair<SVF::NodeID, const GepRef *> &b) {
+                  return std::make_tuple(a.first, a.second->offset, a.second->dst) <
+                         std::make_tuple(b.first, b.second->offset, b.second->dst);
+              });
+    for (auto const& lookup : pendingFieldObjs)
+    {
+        SVF::NodeID fieldObj = getLocRep(getFieldObj(lookup.first, *lookup.second));
+        SVF::NodeID x = getRep(lookup.second->dst);
+        if (pts.addPts(x, fieldObj))
+        {
+            A5_STAT(stats.addFacts(SolverStats::Gep, 1));
+            diffPts.addPts(x, fieldObj);
+            changed.push_back(x);
+        }
+    }
+    pendingFieldObjs.clear();
+    if (!pendingCollapses.empty())
+        applyCollapses(changed);
+}
+
+
+template<class WorkListT>
+void Andersen::solve(WorkListT &worklist, const std::vector<SVF::NodeID> &initial)
+{
+    worklist.pushAll(initial.begin(), initial.end());
 
     // -------------------------------------------------------
     // 2. Main Solver Loop
     // -------------------------------------------------------
-    while (!worklist.empty())
+    // Nodes on collapsed cycles share the set of their representative, so every
+    // lookup and push goes through getRep.
+    // Only the objects added to pts(p) since p was last processed (diffPts) are pushed along
+    // its edges; a new copy edge instead receives the whole set of its source at once.
+    std::vector<SVF::NodeID> cycleCandidates;
+    std::vector<SVF::NodeID> newReps;
+    PointsToSet delta;
+    PointsToSet fresh;
+    PointsToSet fieldObjs;
+    uint64_t sinceMemoryCheck = 0;
+    const bool hasBudget = timeBudget > 0 || iterationBudget;
+    bool stopped = false;
+    while (true)
     {
+        if (worklist.empty())
+        {
+            // Stable up to the field objects not created yet
+            newReps.clear();
+            resolveFieldObjs(newReps);
+            if (newReps.empty())
+                break;
+            worklist.pushAll(newReps.begin(), newReps.end());
+        }
+        uint64_t pops = worklist.getNumPops();
+        if (hasBudget && outOfBudget(pops, pops % 256 == 0))
+        {
+            stopped = true;
+            break;
+        }
         SVF::NodeID p = worklist.pop();
-        SVF::ConstraintNode* pNode = consg->getConstraintNode(p);
-        auto& pts_p = pts[p];
+        if (getRep(p) != p)
+            continue;   // merged away; its representative has been pushed
+        diffPts.takePts(p, delta);
+        if (delta.empty())
+            continue;
 
-        // ---------------------
-        // Handle Store Edges (Incoming)
-        // ---------------------
-        // q -Store-> p  =>  q -Copy-> o
-        for (auto edge : pNode->getInEdges())
+        for (SVF::NodeID m : getMembers(p))
         {
-            if (edge->getEdgeKind() == SVF::ConstraintEdge::Store)
+            // Load/Store constraints only see each object once per pointer
+            const PointsToSet &complexDelta = hasComplexConstraints(m) ? getNewComplexObjs(m, delta, fresh) : delta;
+            A5_STAT(stats.skipInsertions(getNumSkippedInsertions(m, delta, complexDelta)));
+
+            // ---------------------
+            // Handle Store Edges (Incoming)
+            // ---------------------
+            // q -Store-> m  =>  q -Copy-> o
+            for (SVF::NodeID q : csr.getStoreSrcs(m))
             {
-                SVF::NodeID q = edge->getSrcID();
-                for (SVF::NodeID o : pts_p)
+                A5_STAT(stats.fire(SolverStats::Store, complexDelta.size()));
+                for (SVF::NodeID o : complexDelta)
                 {
-                    if (consg->addCopyCGEdge(q, o))
-                        worklist.push(q);
+                    if (addDerivedCopyEdge(q, o) && propagate(getRep(o), getRep(q)))
+                    {
+                        A5_STAT(stats.addFacts(SolverStats::Store, diffScratch.size()));
+                        worklist.push(getRep(o));
+                    }
+                }
+            }
+
+            // ---------------------
+            // Handle Outgoing Edges (Copy, Load, Gep)
+            // ---------------------
+            // Copy Rule: m -Copy-> x, over the static edges and those derived so far
+            auto copyRule = [&](SVF::NodeID dst) {
+                SVF::NodeID x = getRep(dst);
+                if (x == p)
+                    return;
+                A5_STAT(stats.fire(SolverStats::Copy));
+                if (propagate(x, delta))
+                {
+                    A5_STAT(stats.addFacts(SolverStats::Copy, diffScratch.size()));
+                    worklist.push(x);
+                }
+                // Lazy cycle detection: equal sets across a copy edge hint at a cycle
+                else if (pts.getPts(x) == pts.getPts(p) && shouldDetectCycle(m, dst))
+                    cycleCandidates.push_back(x);
+            };
+            for (SVF::NodeID dst : csr.getCopySuccs(m))
+                copyRule(dst);
+            for (SVF::NodeID dst : csr.getNewCopySuccs(m))
+                copyRule(dst);
+
+            // Load Rule: m -Load-> r  =>  o -Copy-> r
+            for (SVF::NodeID r : csr.getLoadSuccs(m))
+            {
+                A5_STAT(stats.fire(SolverStats::Load, complexDelta.size()));
+                for (SVF::NodeID o : complexDelta)
+                {
+                    if (addDerivedCopyEdge(o, r) && propagate(getRep(r), getRep(o)))
+                    {
+                        A5_STAT(stats.addFacts(SolverStats::Load, diffScratch.size()));
+                        worklist.push(getRep(r));
+                    }
+                }
+            }
+
+            // Gep Rule: m -Gep-> x
+            for (const GepRef &gep : csr.getGepSuccs(m))
+            {
+                SVF::NodeID x = getRep(gep.dst);
+                fieldObjs.clear();
+                for (SVF::NodeID o : delta)
+                {
+                    // Helper handles both constant offsets and variable indices
+                    addKnownFieldObjs(o, gep, fieldObjs);
+                }
+                A5_STAT(stats.fire(SolverStats::Gep, delta.size()));
+                if (propagate(x, fieldObjs))
+                {
+                    A5_STAT(stats.addFacts(SolverStats::Gep, diffScratch.size()));
+                    worklist.push(x);
                 }
             }
         }
 
         // ---------------------
-        // Handle Outgoing Edges (Copy, Load, Gep)
+        // Collapse the cycles found by lazy cycle detection
         // ---------------------
-        for (auto edge : pNode->getOutEdges())
+        for (SVF::NodeID x : cycleCandidates)
         {
-            // Fix: Use 'auto' to let compiler deduce 'long long int' type safely
-            auto edgeKind = edge->getEdgeKind();
+            newReps.clear();
+            collapseCycles(getRep(x), newReps);
+            for (SVF::NodeID rep : newReps)
+                worklist.push(rep);
+        }
+        cycleCandidates.clear();
 
-            // Copy Rule: p -Copy-> x
-            if (edgeKind == SVF::ConstraintEdge::Copy)
-            {
-                SVF::NodeID x = edge->getDstID();
-                auto& pts_x = pts[x];
-                
-                size_t oldSize = pts_x.size();
-                pts_x.insert(pts_p.begin(), pts_p.end());
+        // ---------------------
+        // Merge the fields of objects collapsed to field-insensitive ones
+        // ---------------------
+        if (!pendingCollapses.empty())
+        {
+            newReps.clear();
+            applyCollapses(newReps);
+            for (SVF::NodeID rep : newReps)
+                worklist.push(rep);
+        }
 
-                if (pts_x.size() != oldSize)
-                    worklist.push(x);
+        // ---------------------
+        // Degrade precision when the sets near the memory budget
+        // ---------------------
+        if (memoryBudget && ++sinceMemoryCheck >= memoryCheckInterval)
+        {
+            sinceMemoryCheck = 0;
+            newReps.clear();
+            if (checkMemoryBudget(newReps))
+            {
+                pendingFieldObjs.clear();
+                break;  // the unification pass has solved everything
             }
-            // Load Rule: p -Load-> r
-            else if (edgeKind == SVF::ConstraintEdge::Load)
+            for (SVF::NodeID rep : newReps)
+                worklist.push(rep);
+        }
+    }
+
+    numPushes = worklist.getNumPushes();
+    numPops = worklist.getNumPops();
+    if (stopped)
+    {
+        std::vector<SVF::NodeID> order;
+        while (!worklist.empty())
+            order.push_back(worklist.pop());
+        resolveFieldObjs(order);
+        stopSolving(order);
+    }
+}
+
+
+namespace
+{
+/// Run fn(begin, end, thread) over [0, n) in chunks claimed by numThreads threads
+template<class Fn>
+void parallelFor(unsigned numThreads, size_t n, size_t chunk, Fn fn)
+{
+    std::atomic<size_t> next(0);
+    auto worker = [&](unsigned tid) {
+        while (true)
+        {
+            size_t begin = next.fetch_add(chunk);
+            if (begin >= n)
+                break;
+            fn(begin, std::min(n, begin + chunk), tid);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < numThreads; ++t)
+        threads.emplace_back(worker, t);
+    worker(0);
+    for (std::thread &t : threads)
+        t.join();
+}
+}
+
+
+void Andersen::solveParallel(const std::vector<SVF::NodeID> &initial)
+{
+    // Bulk-synchronous rounds. Each round takes the deltas of all representatives with pending
+    // objects (the frontier, in ID order) and
+    //  1. scans their constraints in parallel, collecting copy targets, gep edges and candidate
+    //     derived copy edges per frontier slot, without touching any shared state;
+    //  2. inserts derived edges and looks up field objects sequentially, in frontier order, so the
+    //     constraint graph changes the same way whatever the thread count;
+    //  3. applies the resulting unions in parallel, each destination owned by one thread;
+    //  4. runs lazy cycle detection, field collapsing and the memory budget check sequentially
+    //     and builds the next frontier.
+    // New field objects are created between the rounds once the frontier runs dry, as the
+    // sequential solver does once its worklist does, so the result is the same.
+    struct ScanResult
+    {
+        std::vector<std::pair<SVF::NodeID, SVF::NodeID>> copies;     ///< (member, dst)
+        std::vector<std::pair<SVF::NodeID, SVF::NodeID>> stores;     ///< candidate copy edges of stores
+        std::vector<std::pair<SVF::NodeID, SVF::NodeID>> loads;      ///< candidate copy edges of loads
+        std::vector<const GepRef *> geps;
+        PointsToSet fresh;      ///< scratch for the objects new to a member's Load/Store constraints
+        uint64_t skipped;       ///< Load/Store edge insertions avoided, counted with A5_STATS
+    };
+    struct UnionJob
+    {
+        SVF::NodeID dst;
+        const PointsToSet *objs;
+        SVF::NodeID src;        ///< copy jobs: representative the delta came from
+        SVF::NodeID member;     ///< copy jobs: member whose edge it is, otherwise ~0
+        SVF::NodeID edgeDst;
+        SolverStats::Rule rule;
+        bool changed;
+        uint32_t numNew;        ///< objects the union added, counted with A5_STATS
+    };
+
+    // Concurrent unions are only safe on maps whose slots are independent
+    const unsigned mergeThreads = PTS::ConcurrentSlots ? numThreads : 1;
+
+    std::vector<SVF::NodeID> frontier(initial);
+    std::vector<PointsToSet> deltas;
+    std::vector<ScanResult> scans;
+    std::deque<PointsToSet> jobSets;
+    std::unordered_map<SVF::NodeID, const PointsToSet *> snapshots;
+    std::vector<UnionJob> jobs;
+    std::vector<size_t> groups;
+    std::vector<PointsToSet> scratch(numThreads);
+    std::vector<std::vector<SVF::NodeID>> changed(numThreads);
+    std::vector<SVF::NodeID> newReps;
+
+    while (true)
+    {
+        for (SVF::NodeID &n : frontier)
+            n = getRep(n);
+        std::sort(frontier.begin(), frontier.end());
+        frontier.erase(std::unique(frontier.begin(), frontier.end()), frontier.end());
+        frontier.erase(std::remove_if(frontier.begin(), frontier.end(), [&](SVF::NodeID n) {
+            return diffPts.getPts(n).empty();
+        }), frontier.end());
+        if (frontier.empty())
+        {
+            resolveFieldObjs(frontier);
+            if (frontier.empty())
+                break;
+            continue;
+        }
+        if ((timeBudget > 0 || iterationBudget) && outOfBudget(numPops, true))
+        {
+            resolveFieldObjs(frontier);
+            stopSolving(frontier);
+            break;
+        }
+        numPops += frontier.size();
+
+        size_t numSlots = frontier.size();
+        if (deltas.size() < numSlots)
+        {
+            deltas.resize(numSlots);
+            scans.resize(numSlots);
+        }
+        SVF::NodeID maxMember = 0;
+        for (size_t i = 0; i < numSlots; ++i)
+        {
+            diffPts.takePts(frontier[i], deltas[i]);
+            for (SVF::NodeID m : getMembers(frontier[i]))
+                maxMember = std::max(maxMember, m);
+        }
+        // Each member belongs to one frontier slot, so the scan may update its own entry
+        complexDone.reserve(maxMember + 1);
+
+        // 1. Parallel scan
+        parallelFor(numThreads, numSlots, 16, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; ++i)
             {
-                SVF::NodeID r = edge->getDstID();
-                for (SVF::NodeID o : pts_p)
+                ScanResult &scan = scans[i];
+                scan.copies.clear();
+                scan.stores.clear();
+                scan.loads.clear();
+                scan.skipped = 0;
+                scan.geps.clear();
+                const PointsToSet &delta = deltas[i];
+                for (SVF::NodeID m : getMembers(frontier[i]))
                 {
-                    if (consg->addCopyCGEdge(o, r))
-                        worklist.push(o);
+                    const PointsToSet &complexDelta =
+                            hasComplexConstraints(m) ? getNewComplexObjs(m, delta, scan.fresh) : delta;
+                    A5_STAT(scan.skipped += getNumSkippedInsertions(m, delta, complexDelta));
+                    // q -Store-> m  =>  q -Copy-> o
+                    for (SVF::NodeID q : csr.getStoreSrcs(m))
+                    {
+                        for (SVF::NodeID o : complexDelta)
+                            scan.stores.emplace_back(q, o);
+                    }
+                    for (SVF::NodeID dst : csr.getCopySuccs(m))
+                        scan.copies.emplace_back(m, dst);
+                    for (SVF::NodeID dst : csr.getNewCopySuccs(m))
+                        scan.copies.emplace_back(m, dst);
+                    // m -Load-> r  =>  o -Copy-> r
+                    for (SVF::NodeID r : csr.getLoadSuccs(m))
+                    {
+                        for (SVF::NodeID o : complexDelta)
+                            scan.loads.emplace_back(o, r);
+                    }
+                    for (const GepRef &gep : csr.getGepSuccs(m))
+                        scan.geps.push_back(&gep);
                 }
             }
-            // Gep Rule: p -Gep-> x
-            else if (edgeKind == SVF::ConstraintEdge::NormalGep || 
-                     edgeKind == SVF::ConstraintEdge::VariantGep)
+        });
+
+        // 2. Sequential graph updates, in frontier order
+        jobs.clear();
+        jobSets.clear();
+        snapshots.clear();
+        for (size_t i = 0; i < numSlots; ++i)
+        {
+            SVF::NodeID p = frontier[i];
+            A5_STAT(stats.skipInsertions(scans[i].skipped));
+            auto addDerived = [&](const std::pair<SVF::NodeID, SVF::NodeID> &edge, SolverStats::Rule rule) {
+                SVF::NodeID src = edge.first;
+                SVF::NodeID dst = edge.second;
+                A5_STAT(stats.fire(rule));
+                if (!addDerivedCopyEdge(src, dst))
+                    return;
+                SVF::NodeID srcRep = getRep(src);
+                SVF::NodeID dstRep = getRep(dst);
+                if (srcRep == dstRep)
+                    return;
+                // A new edge carries the whole source set as it was at the start of the round;
+                // whatever the source gains meanwhile is in its delta for the next round.
+                auto snap = snapshots.find(srcRep);
+                if (snap == snapshots.end())
+                {
+                    jobSets.push_back(pts.getPts(srcRep));
+                    snap = snapshots.emplace(srcRep, &jobSets.back()).first;
+                }
+                jobs.push_back({dstRep, snap->second, srcRep, ~0u, dst, rule, false, 0});
+            };
+            for (auto const& edge : scans[i].stores)
+                addDerived(edge, SolverStats::Store);
+            for (auto const& edge : scans[i].loads)
+                addDerived(edge, SolverStats::Load);
+            for (const GepRef *gep : scans[i].geps)
+            {
+                jobSets.emplace_back();
+                for (SVF::NodeID o : deltas[i])
+                    addKnownFieldObjs(o, *gep, jobSets.back());
+                A5_STAT(stats.fire(SolverStats::Gep, deltas[i].size()));
+                jobs.push_back({getRep(gep->dst), &jobSets.back(), p, ~0u, gep->dst, SolverStats::Gep, false, 0});
+            }
+            for (auto const& copy : scans[i].copies)
+            {
+                SVF::NodeID x = getRep(copy.second);
+                if (x == p)
+                    continue;
+                A5_STAT(stats.fire(SolverStats::Copy));
+                jobs.push_back({x, &deltas[i], p, copy.first, copy.second, SolverStats::Copy, false, 0});
+            }
+        }
+
+        // 3. Parallel unions, grouped by destination
+        std::stable_sort(jobs.begin(), jobs.end(), [](const UnionJob &a, const UnionJob &b) {
+            return a.dst < b.dst;
+        });
+        groups.clear();
+        for (size_t j = 0; j < jobs.size(); ++j)
+        {
+            if (j == 0 || jobs[j].dst != jobs[j - 1].dst)
+                groups.push_back(j);
+        }
+        groups.push_back(jobs.size());
+        SVF::NodeID maxId = consg->getTotalNodeNum();
+        for (const UnionJob &job : jobs)
+            maxId = std::max(maxId, job.dst + 1);
+        pts.reserve(maxId);
+        diffPts.reserve(maxId);
+        parallelFor(mergeThreads, groups.size() - 1, 8, [&](size_t begin, size_t end, unsigned tid) {
+            PointsToSet &diff = scratch[tid];
+            for (size_t g = begin; g < end; ++g)
             {
-                // Dyn_cast works because NormalGepCGEdge and VariantGepCGEdge 
-                // both inherit from GepCGEdge
-                if (auto gepEdge = llvm::dyn_cast<SVF::GepCGEdge>(edge))
+                bool any = false;
+                for (size_t j = groups[g]; j < groups[g + 1]; ++j)
                 {
-                    SVF::NodeID x = edge->getDstID();
-                    auto& pts_x = pts[x];
-                    size_t oldSize = pts_x.size();
+                    UnionJob &job = jobs[j];
+                    diff = *job.objs;
+                    diff.subtract(pts.getPts(job.dst));
+                    if (diff.empty())
+                        continue;
+                    pts.unionPts(job.dst, diff);
+                    diffPts.unionPts(job.dst, diff);
+                    job.changed = any = true;
+                    A5_STAT(job.numNew = diff.size());
+                }
+                if (any)
+                    changed[tid].push_back(jobs[groups[g]].dst);
+            }
+        });
 
-                    for (SVF::NodeID o : pts_p)
-                    {
-                        // Helper handles both constant offsets and variable indices
-                        SVF::NodeID fieldObj = consg->getGepObjVar(o, gepEdge);
-                        pts_x.insert(fieldObj);
-                    }
+        // 4. Lazy cycle detection on copy edges that brought nothing new, then the next frontier
+        frontier.clear();
+        for (std::vector<SVF::NodeID> &c : changed)
+        {
+            frontier.insert(frontier.end(), c.begin(), c.end());
+            c.clear();
+        }
+        for (const UnionJob &job : jobs)
+        {
+            A5_STAT(stats.addFacts(job.rule, job.numNew));
+            if (job.member == ~0u || job.changed)
+                continue;
+            SVF::NodeID x = getRep(job.edgeDst);
+            SVF::NodeID p = getRep(job.src);
+            if (x != p && pts.getPts(x) == pts.getPts(p) && shouldDetectCycle(job.member, job.edgeDst))
+            {
+                newReps.clear();
+                collapseCycles(x, newReps);
+                frontier.insert(frontier.end(), newReps.begin(), newReps.end());
+            }
+        }
+        if (!pendingCollapses.empty())
+            applyCollapses(frontier);
+        if (memoryBudget && checkMemoryBudget(frontier))
+        {
+            pendingFieldObjs.clear();
+            break;
+        }
+        numPushes += frontier.size();
+    }
+}
 
-                    if (pts_x.size() != oldSize)
-                        worklist.push(x);
-                }
+
+unsigned Andersen::computeSCCs(unsigned kindMask, std::vector<unsigned> &sccOf)
+{
+    // Iterative Tarjan over the static graph. SCCs complete in reverse topological order.
+    SVF::NodeID numIds = 0;
+    for (auto const& iter : *consg)
+        numIds = std::max(numIds, iter.first + 1);
+
+    const unsigned unvisited = ~0u;
+    std::vector<unsigned> order(numIds, unvisited);
+    std::vector<unsigned> lowLink(numIds, 0);
+    std::vector<bool> onStack(numIds, false);
+    std::vector<SVF::NodeID> sccStack;
+    std::vector<std::pair<SVF::NodeID, std::vector<SVF::NodeID>>> dfs;
+    std::vector<size_t> next;
+    unsigned index = 0;
+    unsigned numSCCs = 0;
+    sccOf.assign(numIds, 0);
+
+    auto visit = [&](SVF::NodeID n) {
+        order[n] = lowLink[n] = index++;
+        sccStack.push_back(n);
+        onStack[n] = true;
+        std::vector<SVF::NodeID> succs;
+        for (auto edge : consg->getConstraintNode(n)->getOutEdges())
+        {
+            if (kindMask & (1u << edge->getEdgeKind()))
+                succs.push_back(edge->getDstID());
+        }
+        dfs.emplace_back(n, std::move(succs));
+        next.push_back(0);
+    };
+
+    for (auto const& iter : *consg)
+    {
+        if (order[iter.first] != unvisited)
+            continue;
+        visit(iter.first);
+        while (!dfs.empty())
+        {
+            SVF::NodeID n = dfs.back().first;
+            if (next.back() < dfs.back().second.size())
+            {
+                SVF::NodeID succ = dfs.back().second[next.back()++];
+                if (order[succ] == unvisited)
+                    visit(succ);
+                else if (onStack[succ])
+                    lowLink[n] = std::min(lowLink[n], order[succ]);
+                continue;
             }
+
+            dfs.pop_back();
+            next.pop_back();
+            if (!dfs.empty())
+                lowLink[dfs.back().first] = std::min(lowLink[dfs.back().first], lowLink[n]);
+            if (lowLink[n] != order[n])
+                continue;
+            while (true)
+            {
+                SVF::NodeID member = sccStack.back();
+                sccStack.pop_back();
+                onStack[member] = false;
+                sccOf[member] = numSCCs;
+                if (member == n)
+                    break;
+            }
+            ++numSCCs;
+        }
+    }
+    return numSCCs;
+}
+
+
+void Andersen::computeTopoRanks(std::vector<unsigned> &ranks)
+{
+    // Follow the edges along which points-to sets flow directly: copy, gep and the
+    // pointer-to-result side of loads
+    unsigned kindMask = (1u << SVF::ConstraintEdge::Copy) | (1u << SVF::ConstraintEdge::Load) |
+                        (1u << SVF::ConstraintEdge::NormalGep) | (1u << SVF::ConstraintEdge::VariantGep);
+    std::vector<unsigned> sccOf;
+    unsigned numSCCs = computeSCCs(kindMask, sccOf);
+    ranks.resize(sccOf.size());
+    for (SVF::NodeID n = 0; n < sccOf.size(); ++n)
+        ranks[n] = numSCCs - 1 - sccOf[n];
+}
+
+
+bool Andersen::propagate(SVF::NodeID dst, const PointsToSet &objs)
+{
+    diffScratch = objs;
+    diffScratch.subtract(pts.getPts(dst));
+    if (diffScratch.empty())
+        return false;
+    pts.unionPts(dst, diffScratch);
+    diffPts.unionPts(dst, diffScratch);
+    return true;
+}
+
+
+bool Andersen::propagate(SVF::NodeID dst, SVF::NodeID src)
+{
+    if (dst == src)
+        return false;
+    return propagate(dst, pts.getPts(src));
+}
+
+
+bool Andersen::shouldDetectCycle(SVF::NodeID src, SVF::NodeID dst)
+{
+    return lcdEdges.insert(((uint64_t) src << 32) | dst).second;
+}
+
+
+void Andersen::mergeNodes(SVF::NodeID rep, SVF::NodeID n)
+{
+    if (rep == n)
+        return;
+    if (repOf.size() <= std::max(rep, n))
+    {
+        SVF::NodeID old = repOf.size();
+        repOf.resize(std::max(rep, n) + 1);
+        for (SVF::NodeID i = old; i < repOf.size(); ++i)
+            repOf[i] = i;
+    }
+    repOf[n] = rep;
+
+    // Move members and points-to set over to the representative
+    auto &repMembers = sccMembers[rep];
+    if (repMembers.empty())
+        repMembers.push_back(rep);
+    auto it = sccMembers.find(n);
+    if (it == sccMembers.end())
+        repMembers.push_back(n);
+    else
+    {
+        repMembers.insert(repMembers.end(), it->second.begin(), it->second.end());
+        sccMembers.erase(it);
+    }
+    pts.unionPts(rep, n);
+    pts.clearPts(n);
+    diffPts.clearPts(n);
+    // The members' edges have only seen their own sets: push the whole merged set again
+    diffPts.unionPts(rep, pts.getPts(rep));
+
+    // Cached successors of both sides are rebuilt on demand
+    copySuccs.erase(rep);
+    copySuccs.erase(n);
+}
+
+
+const std::vector<SVF::NodeID> &Andersen::getCopySuccs(SVF::NodeID rep)
+{
+    auto it = copySuccs.find(rep);
+    if (it != copySuccs.end())
+        return it->second;
+
+    std::vector<SVF::NodeID> &succs = copySuccs[rep];
+    for (SVF::NodeID m : getMembers(rep))
+    {
+        for (SVF::NodeID dst : csr.getCopySuccs(m))
+            succs.push_back(getRep(dst));
+        for (SVF::NodeID dst : csr.getNewCopySuccs(m))
+            succs.push_back(getRep(dst));
+    }
+    std::sort(succs.begin(), succs.end());
+    succs.erase(std::unique(succs.begin(), succs.end()), succs.end());
+    succs.erase(std::remove(succs.begin(), succs.end(), rep), succs.end());
+    return succs;
+}
+
+
+bool Andersen::addDerivedCopyEdge(SVF::NodeID src, SVF::NodeID dst)
+{
+    if (!consg->addCopyCGEdge(src, dst))
+    {
+        A5_STAT(stats.addDuplicateEdge());
+        return false;
+    }
+    A5_STAT(stats.addCopyEdge());
+    csr.addCopyEdge(src, dst);
+    pts.touch(src);
+    auto it = copySuccs.find(getRep(src));
+    if (it != copySuccs.end())
+        it->second.push_back(dst);
+    return true;
+}
+
+
+void Andersen::collapseCycles(SVF::NodeID start, std::vector<SVF::NodeID> &newReps)
+{
+    // Iterative Tarjan over the copy edges between representatives. Nodes on a cycle end up with
+    // the same points-to set, so the search only follows nodes whose set equals the one of start.
+    const PointsToSet startPts = pts.getPts(start);
+    struct Frame
+    {
+        SVF::NodeID node;
+        std::vector<SVF::NodeID> succs;
+        size_t next;
+    };
+    std::unordered_map<SVF::NodeID, unsigned> order;
+    std::unordered_map<SVF::NodeID, unsigned> lowLink;
+    std::unordered_set<SVF::NodeID> onStack;
+    std::vector<SVF::NodeID> sccStack;
+    std::vector<Frame> dfs;
+
+    auto visit = [&](SVF::NodeID n) {
+        unsigned idx = order.size() + 1;
+        order[n] = lowLink[n] = idx;
+        sccStack.push_back(n);
+        onStack.insert(n);
+        Frame frame{n, {}, 0};
+        for (SVF::NodeID succ : getCopySuccs(n))
+        {
+            succ = getRep(succ);
+            if (succ != n && pts.getPts(succ) == startPts)
+                frame.succs.push_back(succ);
         }
+        dfs.push_back(std::move(frame));
+    };
+
+    visit(start);
+    while (!dfs.empty())
+    {
+        Frame &frame = dfs.back();
+        if (frame.next < frame.succs.size())
+        {
+            SVF::NodeID succ = frame.succs[frame.next++];
+            if (!order.count(succ))
+                visit(succ);
+            else if (onStack.count(succ))
+                lowLink[frame.node] = std::min(lowLink[frame.node], order[succ]);
+            continue;
+        }
+
+        SVF::NodeID n = frame.node;
+        dfs.pop_back();
+        if (!dfs.empty())
+            lowLink[dfs.back().node] = std::min(lowLink[dfs.back().node], lowLink[n]);
+        if (lowLink[n] != order[n])
+            continue;
+
+        // n is the root of an SCC: pop it and merge the members into n
+        bool collapsed = false;
+        while (true)
+        {
+            SVF::NodeID member = sccStack.back();
+            sccStack.pop_back();
+            onStack.erase(member);
+            if (member == n)
+                break;
+            mergeNodes(n, member);
+            collapsed = true;
+        }
+        if (collapsed)
+            newReps.push_back(n);
     }
-}
\ No newline at end of file
+}
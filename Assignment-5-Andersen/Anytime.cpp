@@ -0,0 +1,104 @@
+/**
+ * Anytime.cpp
+ * @author kisslune
+ */
+
+#include "A5Header.h"
+
+bool Andersen::outOfBudget(uint64_t pops, bool checkClock)
+{
+    if (iterationBudget && pops >= iterationBudget)
+        return true;
+    return timeBudget > 0 && checkClock && std::chrono::steady_clock::now() >= deadline;
+}
+
+
+void Andersen::stopSolving(const std::vector<SVF::NodeID> &order)
+{
+    budgetExpired = true;
+    pendingNodes.clear();
+    std::unordered_set<SVF::NodeID> seen;
+    auto addPending = [&](SVF::NodeID n) {
+        n = getRep(n);
+        if (!diffPts.getPts(n).empty() && seen.insert(n).second)
+            pendingNodes.push_back(n);
+    };
+    for (SVF::NodeID n : order)
+        addPending(n);
+    for (SVF::NodeID n = 0; n < diffPts.size(); ++n)
+        addPending(n);
+    markInFlight();
+}
+
+
+void Andersen::markInFlight()
+{
+    // Forward closure from the pending nodes. Sets flow along copy (static and derived), gep and
+    // load edges; a store whose source may change changes the objects its pointer points to, and
+    // a store whose pointer may gain objects can change objects not in any set yet, so then every
+    // object counts as in flight. Node IDs need not be dense, so the bits grow to the IDs marked.
+    inFlight.assign(getNumSolvedIds(), false);
+    std::vector<SVF::NodeID> stack;
+    auto mark = [&](SVF::NodeID n) {
+        for (SVF::NodeID m : getMembers(getRep(n)))
+        {
+            if (m >= inFlight.size())
+                inFlight.resize(m + 1, false);
+            if (!inFlight[m])
+            {
+                inFlight[m] = true;
+                stack.push_back(m);
+            }
+        }
+    };
+    auto markPointees = [&](SVF::NodeID n) {
+        for (SVF::NodeID o : pts.getPts(getRep(n)))
+        {
+            for (SVF::NodeID obj : getLocMembers(o))
+                mark(obj);
+        }
+    };
+
+    for (SVF::NodeID n : pendingNodes)
+        mark(n);
+    bool allObjects = false;
+    while (!stack.empty())
+    {
+        SVF::NodeID n = stack.back();
+        stack.pop_back();
+        if (!consg->hasConstraintNode(n))
+            continue;
+        SVF::ConstraintNode *node = consg->getConstraintNode(n);
+        for (auto edge : node->getOutEdges())
+        {
+            switch (edge->getEdgeKind())
+            {
+            case SVF::ConstraintEdge::Copy:
+            case SVF::ConstraintEdge::Load:
+            case SVF::ConstraintEdge::NormalGep:
+            case SVF::ConstraintEdge::VariantGep:
+                mark(edge->getDstID());
+                break;
+            case SVF::ConstraintEdge::Store:
+                markPointees(edge->getDstID());
+                break;
+            default:
+                break;
+            }
+        }
+        if (allObjects)
+            continue;
+        for (auto edge : node->getInEdges())
+        {
+            if (edge->getEdgeKind() != SVF::ConstraintEdge::Store)
+                continue;
+            allObjects = true;
+            for (SVF::NodeID p = 0; p < pts.size(); ++p)
+            {
+                if (getRep(p) == p)
+                    markPointees(p);
+            }
+            break;
+        }
+    }
+}
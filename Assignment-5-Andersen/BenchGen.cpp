@@ -0,0 +1,218 @@
+/**
+ * BenchGen.cpp
+ * Generate synthetic LLVM IR programs whose constraint graphs stress the Andersen solver.
+ *
+ * The program is what clang -O0 makes of pointer-heavy C: pointer variables are globals, and
+ * every statement goes through memory, so each kind of statement ends up as the matching
+ * constraints of the graph:
+ *   addr   v = &o          store ptr @o, ptr @v
+ *   copy   v = w           load w, store into v
+ *   load   v = *w          load w, load through it, store into v
+ *   store  *v = w          load v and w, store w through v
+ *   gep    v = &w->f       load w, getelementptr field f, store into v
+ * Cycles are rings of copies v1 = v2, v2 = v3, ..., vk = v1.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct GenOptions
+{
+    uint64_t nodes = 100000;            ///< approximate number of constraint-graph nodes
+    double mix[5] = {2, 4, 2, 2, 1};    ///< relative weights of addr, copy, load, store, gep
+    double cycles = 0.05;               ///< probability that a copy is a ring of 3-8 copies instead
+    unsigned fields = 4;                ///< pointer fields per struct object
+    unsigned seed = 1;
+    std::string output = "bench.ll";
+};
+
+enum StmtKind
+{
+    Addr, Copy, Load, Store, Gep
+};
+
+/// Statements per generated function, to keep functions a manageable size
+const uint64_t StmtsPerFunction = 4096;
+
+bool parseArgs(int argc, char **argv, GenOptions &opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string name = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (name == "-nodes")
+            opts.nodes = std::strtoull(value.c_str(), nullptr, 10);
+        else if (name == "-mix")
+        {
+            std::istringstream fields(value);
+            std::string weight;
+            for (double &w : opts.mix)
+            {
+                if (!std::getline(fields, weight, ','))
+                    return false;
+                w = std::strtod(weight.c_str(), nullptr);
+            }
+        }
+        else if (name == "-cycles")
+            opts.cycles = std::strtod(value.c_str(), nullptr);
+        else if (name == "-fields")
+            opts.fields = std::strtoul(value.c_str(), nullptr, 10);
+        else if (name == "-seed")
+            opts.seed = std::strtoul(value.c_str(), nullptr, 10);
+        else if (name == "-o")
+            opts.output = value;
+        else
+            return false;
+    }
+    return opts.nodes > 0 && opts.fields > 0 && opts.cycles >= 0 && opts.cycles <= 1;
+}
+}
+
+
+int main(int argc, char **argv)
+{
+    GenOptions opts;
+    if (!parseArgs(argc, argv, opts))
+    {
+        std::cerr << "usage: " << argv[0] << " [-nodes=N] [-mix=addr,copy,load,store,gep] [-cycles=F] "
+                  << "[-fields=N] [-seed=N] [-o=out.ll]\n";
+        return 1;
+    }
+    std::ofstream out(opts.output);
+    if (!out)
+    {
+        std::cerr << "error opening " << opts.output << "\n";
+        return 1;
+    }
+
+    // Globals take two nodes each (pointer and object); statements add about one node per
+    // instruction that yields a value (loads and geps). Size the program to hit opts.nodes.
+    const double cost[5] = {0, 1, 2, 2, 2};
+    double weightSum = 0;
+    double avgCost = 0;
+    for (unsigned k = 0; k < 5; ++k)
+    {
+        weightSum += opts.mix[k];
+        avgCost += opts.mix[k] * cost[k];
+    }
+    if (weightSum <= 0)
+    {
+        std::cerr << "the statement mix needs a positive weight\n";
+        return 1;
+    }
+    avgCost = std::max(avgCost / weightSum, 0.5);
+    uint64_t numVars = std::max<uint64_t>(opts.nodes / 8, 2);
+    uint64_t numObjs = std::max<uint64_t>(opts.nodes / 16, 1);
+    double left = (double) opts.nodes - 2.0 * (numVars + numObjs);
+    uint64_t numStmts = left > 0 ? (uint64_t) (left / avgCost) : numVars;
+
+    std::mt19937_64 rng(opts.seed);
+    std::discrete_distribution<unsigned> pickKind(opts.mix, opts.mix + 5);
+    std::uniform_int_distribution<uint64_t> pickVar(0, numVars - 1);
+    std::uniform_int_distribution<uint64_t> pickObj(0, numObjs - 1);
+    std::uniform_int_distribution<unsigned> pickField(0, opts.fields - 1);
+    std::uniform_int_distribution<unsigned> pickRing(3, 8);
+    std::bernoulli_distribution inCycle(opts.cycles);
+
+    out << "; synthetic Andersen benchmark: nodes=" << opts.nodes << " cycles=" << opts.cycles
+        << " fields=" << opts.fields << " seed=" << opts.seed << "\n";
+    out << "%S = type {";
+    for (unsigned f = 0; f < opts.fields; ++f)
+        out << (f ? ", ptr" : " ptr");
+    out << " }\n\n";
+    for (uint64_t v = 0; v < numVars; ++v)
+        out << "@v" << v << " = global ptr null\n";
+    for (uint64_t o = 0; o < numObjs; ++o)
+        out << "@o" << o << " = global %S zeroinitializer\n";
+
+    uint64_t numFunctions = 0;
+    uint64_t stmtsInFunction = 0;
+    uint64_t temp = 0;
+    auto loadVar = [&](uint64_t v) {
+        out << "  %t" << temp << " = load ptr, ptr @v" << v << "\n";
+        return temp++;
+    };
+    for (uint64_t stmt = 0; stmt < numStmts;)
+    {
+        if (numFunctions == 0 || stmtsInFunction >= StmtsPerFunction)
+        {
+            if (numFunctions)
+                out << "  ret void\n}\n";
+            out << "\ndefine void @f" << numFunctions++ << "() {\nentry:\n";
+            stmtsInFunction = 0;
+            temp = 0;
+        }
+        uint64_t before = stmt;
+        switch (pickKind(rng))
+        {
+        case Addr:
+            out << "  store ptr @o" << pickObj(rng) << ", ptr @v" << pickVar(rng) << "\n";
+            ++stmt;
+            break;
+        case Copy:
+        {
+            unsigned length = inCycle(rng) ? pickRing(rng) : 1;
+            std::vector<uint64_t> ring(length + 1);
+            for (uint64_t &v : ring)
+                v = pickVar(rng);
+            if (length > 1)
+                ring[length] = ring[0];
+            for (unsigned i = 0; i < length; ++i)
+            {
+                uint64_t t = loadVar(ring[i + 1]);
+                out << "  store ptr %t" << t << ", ptr @v" << ring[i] << "\n";
+            }
+            stmt += length;
+            break;
+        }
+        case Load:
+        {
+            uint64_t t = loadVar(pickVar(rng));
+            out << "  %t" << temp << " = load ptr, ptr %t" << t << "\n";
+            out << "  store ptr %t" << temp++ << ", ptr @v" << pickVar(rng) << "\n";
+            ++stmt;
+            break;
+        }
+        case Store:
+        {
+            uint64_t dst = loadVar(pickVar(rng));
+            uint64_t src = loadVar(pickVar(rng));
+            out << "  store ptr %t" << src << ", ptr %t" << dst << "\n";
+            ++stmt;
+            break;
+        }
+        case Gep:
+        {
+            uint64_t t = loadVar(pickVar(rng));
+            out << "  %t" << temp << " = getelementptr %S, ptr %t" << t << ", i32 0, i32 " << pickField(rng) << "\n";
+            out << "  store ptr %t" << temp++ << ", ptr @v" << pickVar(rng) << "\n";
+            ++stmt;
+            break;
+        }
+        }
+        stmtsInFunction += stmt - before;
+    }
+    if (numFunctions)
+        out << "  ret void\n}\n";
+
+    // Keep the statements reachable from main
+    out << "\ndefine i32 @main() {\nentry:\n";
+    for (uint64_t f = 0; f < numFunctions; ++f)
+        out << "  call void @f" << f << "()\n";
+    out << "  ret i32 0\n}\n";
+
+    std::cout << opts.output << ": " << numVars << " variables, " << numObjs << " objects, " << numStmts
+              << " statements in " << numFunctions << " functions\n";
+    return 0;
+}
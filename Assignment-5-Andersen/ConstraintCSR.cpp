@@ -0,0 +1,81 @@
+/**
+ * ConstraintCSR.cpp
+ * @author kisslune
+ */
+
+#include "ConstraintCSR.h"
+
+void ConstraintCSR::build(SVF::ConstraintGraph *consg)
+{
+    SVF::NodeID numIds = 0;
+    for (auto const& iter : *consg)
+        numIds = std::max(numIds, iter.first + 1);
+
+    // Count the edges of each row, then turn the counts into row offsets
+    copyRows.assign(numIds + 1, 0);
+    loadRows.assign(numIds + 1, 0);
+    storeRows.assign(numIds + 1, 0);
+    gepRows.assign(numIds + 1, 0);
+    for (auto const& iter : *consg)
+    {
+        for (auto edge : iter.second->getOutEdges())
+        {
+            auto edgeKind = edge->getEdgeKind();
+            if (edgeKind == SVF::ConstraintEdge::Copy)
+                ++copyRows[edge->getSrcID() + 1];
+            else if (edgeKind == SVF::ConstraintEdge::Load)
+                ++loadRows[edge->getSrcID() + 1];
+            else if (edgeKind == SVF::ConstraintEdge::Store)
+                ++storeRows[edge->getDstID() + 1];
+            else if (edgeKind == SVF::ConstraintEdge::NormalGep || edgeKind == SVF::ConstraintEdge::VariantGep)
+                ++gepRows[edge->getSrcID() + 1];
+        }
+    }
+    for (SVF::NodeID n = 0; n < numIds; ++n)
+    {
+        copyRows[n + 1] += copyRows[n];
+        loadRows[n + 1] += loadRows[n];
+        storeRows[n + 1] += storeRows[n];
+        gepRows[n + 1] += gepRows[n];
+    }
+
+    copyDsts.resize(copyRows[numIds]);
+    loadDsts.resize(loadRows[numIds]);
+    storeSrcs.resize(storeRows[numIds]);
+    geps.resize(gepRows[numIds]);
+    std::vector<uint32_t> copyNext(copyRows.begin(), copyRows.end() - 1);
+    std::vector<uint32_t> loadNext(loadRows.begin(), loadRows.end() - 1);
+    std::vector<uint32_t> storeNext(storeRows.begin(), storeRows.end() - 1);
+    std::vector<uint32_t> gepNext(gepRows.begin(), gepRows.end() - 1);
+    for (auto const& iter : *consg)
+    {
+        for (auto edge : iter.second->getOutEdges())
+        {
+            SVF::NodeID src = edge->getSrcID();
+            SVF::NodeID dst = edge->getDstID();
+            auto edgeKind = edge->getEdgeKind();
+            if (edgeKind == SVF::ConstraintEdge::Copy)
+                copyDsts[copyNext[src]++] = dst;
+            else if (edgeKind == SVF::ConstraintEdge::Load)
+                loadDsts[loadNext[src]++] = dst;
+            else if (edgeKind == SVF::ConstraintEdge::Store)
+                storeSrcs[storeNext[dst]++] = src;
+            else if (auto gepEdge = llvm::dyn_cast<SVF::GepCGEdge>(edge))
+            {
+                GepRef &ref = geps[gepNext[src]++];
+                ref.dst = dst;
+                ref.edge = gepEdge;
+                ref.offset = 0;
+                ref.variant = true;
+                if (auto normalGep = llvm::dyn_cast<SVF::NormalGepCGEdge>(edge))
+                {
+                    ref.offset = normalGep->getConstantFieldIdx();
+                    ref.variant = false;
+                }
+            }
+        }
+    }
+
+    overflow.clear();
+    overflow.resize(numIds);
+}
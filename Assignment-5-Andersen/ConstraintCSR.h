@@ -0,0 +1,115 @@
+/**
+ * ConstraintCSR.h
+ * Flat, kind-partitioned snapshot of the constraint graph used by the Andersen solver.
+ */
+
+#ifndef ANSWERS_CONSTRAINTCSR_H
+#define ANSWERS_CONSTRAINTCSR_H
+
+#include "SVF-LLVM/SVFIRBuilder.h"
+#include <algorithm>
+#include <vector>
+
+/// A contiguous range of elements
+template<class T>
+struct Span
+{
+    const T *first;
+    const T *last;
+
+    inline const T *begin() const
+    { return first; }
+
+    inline const T *end() const
+    { return last; }
+
+    inline size_t size() const
+    { return last - first; }
+
+    inline bool empty() const
+    { return first == last; }
+};
+
+
+/// A gep edge with its offset decoded
+struct GepRef
+{
+    SVF::NodeID dst;
+    SVF::GepCGEdge *edge;
+    SVF::APOffset offset;   ///< constant field index, unused for variant geps
+    bool variant;
+};
+
+
+/**
+ * Compressed sparse rows over the constraint graph, one set of rows per edge kind the solver
+ * visits: copy and load successors, gep successors, and store sources (q for q -Store-> n).
+ * The rows are built once from the static graph; copy edges added while solving go to per-node
+ * overflow buffers. Nodes created after the snapshot (field objects) only have overflow edges.
+ */
+class ConstraintCSR
+{
+public:
+    /// Snapshot the edges of all nodes of consg
+    void build(SVF::ConstraintGraph *consg);
+
+    /// Number of nodes covered by the static rows
+    inline size_t numNodes() const
+    { return copyRows.size() ? copyRows.size() - 1 : 0; }
+
+    /// Static copy successors
+    inline Span<SVF::NodeID> getCopySuccs(SVF::NodeID n) const
+    { return row(copyRows, copyDsts, n); }
+
+    /// Copy successors added while solving
+    inline Span<SVF::NodeID> getNewCopySuccs(SVF::NodeID n) const
+    {
+        if (n >= overflow.size())
+            return {nullptr, nullptr};
+        return {overflow[n].data(), overflow[n].data() + overflow[n].size()};
+    }
+
+    /// Results r of n -Load-> r
+    inline Span<SVF::NodeID> getLoadSuccs(SVF::NodeID n) const
+    { return row(loadRows, loadDsts, n); }
+
+    /// Sources q of q -Store-> n
+    inline Span<SVF::NodeID> getStoreSrcs(SVF::NodeID n) const
+    { return row(storeRows, storeSrcs, n); }
+
+    inline Span<GepRef> getGepSuccs(SVF::NodeID n) const
+    { return row(gepRows, geps, n); }
+
+    /// Number of nodes that may have copy edges added while solving
+    inline size_t numOverflowRows() const
+    { return overflow.size(); }
+
+    /// Record a copy edge added to the constraint graph while solving
+    inline void addCopyEdge(SVF::NodeID src, SVF::NodeID dst)
+    {
+        if (src >= overflow.size())
+            overflow.resize(src + 1);
+        overflow[src].push_back(dst);
+    }
+
+private:
+    template<class T>
+    static inline Span<T> row(const std::vector<uint32_t> &rows, const std::vector<T> &cols, SVF::NodeID n)
+    {
+        if ((size_t) n + 1 >= rows.size())
+            return {nullptr, nullptr};
+        return {cols.data() + rows[n], cols.data() + rows[n + 1]};
+    }
+
+    std::vector<uint32_t> copyRows;
+    std::vector<SVF::NodeID> copyDsts;
+    std::vector<uint32_t> loadRows;
+    std::vector<SVF::NodeID> loadDsts;
+    std::vector<uint32_t> storeRows;
+    std::vector<SVF::NodeID> storeSrcs;
+    std::vector<uint32_t> gepRows;
+    std::vector<GepRef> geps;
+    std::vector<std::vector<SVF::NodeID>> overflow;     ///< copy edges added while solving
+};
+
+#endif //ANSWERS_CONSTRAINTCSR_H
@@ -0,0 +1,238 @@
+/**
+ * Demand.cpp
+ * @author kisslune
+ */
+
+#include "A5Header.h"
+
+const PointsToSet &Andersen::pointsTo(SVF::NodeID n)
+{
+    solveDemand(std::vector<SVF::NodeID>{n});
+    return pts.getPts(n);
+}
+
+
+std::vector<PointsToSet> Andersen::pointsTo(const std::vector<SVF::NodeID> &nodes)
+{
+    solveDemand(nodes);
+    std::vector<PointsToSet> result;
+    result.reserve(nodes.size());
+    for (SVF::NodeID n : nodes)
+        result.push_back(pts.getPts(n));
+    return result;
+}
+
+
+void Andersen::solveDemand(const std::vector<SVF::NodeID> &nodes)
+{
+    // Only demanded nodes hold points-to sets, and every predecessor of a demanded node along
+    // Addr, copy, gep and load edges is demanded too. Rules fire only towards demanded nodes:
+    //  - a load p -Load-> r demands the objects o in pts(p) and adds o -Copy-> r,
+    //  - a store q -Store-> p adds q -Copy-> o for the demanded objects o in pts(p); the
+    //    others are remembered and replayed once they are demanded,
+    //  - the set of an object depends on every store, so demanding the first object demands
+    //    all store pointers.
+    // Sets, derived edges and demanded nodes persist, so later queries only solve what is new.
+    if (!demandReady)
+    {
+        csr.build(consg);
+        pts.reserve(consg->getTotalNodeNum());
+        diffPts.reserve(consg->getTotalNodeNum());
+        for (SVF::NodeID n = 0; n < csr.numNodes(); ++n)
+        {
+            if (!csr.getStoreSrcs(n).empty())
+                storePtrs.push_back(n);
+        }
+        demandReady = true;
+    }
+
+    DenseWorkList<SVF::NodeID> worklist;
+    worklist.reserve(consg->getTotalNodeNum());
+    for (SVF::NodeID n : nodes)
+    {
+        if (consg->hasConstraintNode(n))
+            demand(n, false, worklist);
+    }
+
+    PointsToSet delta;
+    PointsToSet fieldObjs;
+    while (!worklist.empty())
+    {
+        SVF::NodeID p = worklist.pop();
+        diffPts.takePts(p, delta);
+        if (delta.empty())
+            continue;
+
+        // q -Store-> p  =>  q -Copy-> o
+        if (!csr.getStoreSrcs(p).empty())
+        {
+            for (SVF::NodeID o : delta)
+            {
+                if (!isDemanded(o))
+                {
+                    pendingStores[o].push_back(p);
+                    continue;
+                }
+                for (SVF::NodeID q : csr.getStoreSrcs(p))
+                {
+                    demand(q, false, worklist);
+                    A5_STAT(stats.fire(SolverStats::Store));
+                    if (addDerivedCopyEdge(q, o) && propagate(o, q))
+                    {
+                        A5_STAT(stats.addFacts(SolverStats::Store, diffScratch.size()));
+                        worklist.push(o);
+                    }
+                }
+            }
+        }
+
+        // p -Copy-> x
+        auto copyRule = [&](SVF::NodeID x) {
+            if (!isDemanded(x))
+                return;
+            A5_STAT(stats.fire(SolverStats::Copy));
+            if (propagate(x, delta))
+            {
+                A5_STAT(stats.addFacts(SolverStats::Copy, diffScratch.size()));
+                worklist.push(x);
+            }
+        };
+        for (SVF::NodeID x : csr.getCopySuccs(p))
+            copyRule(x);
+        for (SVF::NodeID x : csr.getNewCopySuccs(p))
+            copyRule(x);
+
+        // p -Load-> r  =>  o -Copy-> r
+        for (SVF::NodeID r : csr.getLoadSuccs(p))
+        {
+            if (!isDemanded(r))
+                continue;
+            A5_STAT(stats.fire(SolverStats::Load, delta.size()));
+            for (SVF::NodeID o : delta)
+            {
+                demand(o, true, worklist);
+                if (addDerivedCopyEdge(o, r) && propagate(r, o))
+                {
+                    A5_STAT(stats.addFacts(SolverStats::Load, diffScratch.size()));
+                    worklist.push(r);
+                }
+            }
+        }
+
+        // p -Gep-> x
+        for (const GepRef &gep : csr.getGepSuccs(p))
+        {
+            if (!isDemanded(gep.dst))
+                continue;
+            fieldObjs.clear();
+            for (SVF::NodeID o : delta)
+                addFieldObjs(o, gep, fieldObjs);
+            A5_STAT(stats.fire(SolverStats::Gep, delta.size()));
+            if (propagate(gep.dst, fieldObjs))
+            {
+                A5_STAT(stats.addFacts(SolverStats::Gep, diffScratch.size()));
+                worklist.push(gep.dst);
+            }
+        }
+    }
+
+    numPushes += worklist.getNumPushes();
+    numPops += worklist.getNumPops();
+}
+
+
+void Andersen::demand(SVF::NodeID n, bool pointee, DenseWorkList<SVF::NodeID> &worklist)
+{
+    if (isDemanded(n))
+        return;
+
+    std::vector<SVF::NodeID> stack{n};
+    std::vector<SVF::NodeID> newNodes;
+    while (!stack.empty())
+    {
+        SVF::NodeID x = stack.back();
+        stack.pop_back();
+        if (isDemanded(x))
+            continue;
+        if (x >= demanded.size())
+            demanded.resize(std::max<size_t>(x + 1, consg->getTotalNodeNum()), false);
+        demanded[x] = true;
+        newNodes.push_back(x);
+        ++numDemanded;
+
+        // Field objects are created while solving, so they are not in the snapshot
+        SVF::ConstraintNode *node = consg->getConstraintNode(x);
+        bool isObject = (x == n && pointee) || x >= csr.numNodes();
+        for (auto edge : node->getOutEdges())
+        {
+            if (edge->getEdgeKind() == SVF::ConstraintEdge::Addr)
+                isObject = true;
+        }
+        for (auto edge : node->getInEdges())
+        {
+            SVF::NodeID src = edge->getSrcID();
+            switch (edge->getEdgeKind())
+            {
+            case SVF::ConstraintEdge::Addr:
+                A5_STAT(stats.fire(SolverStats::Addr));
+                if (pts.addPts(x, src))
+                {
+                    A5_STAT(stats.addFacts(SolverStats::Addr, 1));
+                    diffPts.addPts(x, src);
+                    worklist.push(x);
+                }
+                break;
+            case SVF::ConstraintEdge::Copy:
+            case SVF::ConstraintEdge::Load:
+            case SVF::ConstraintEdge::NormalGep:
+            case SVF::ConstraintEdge::VariantGep:
+                stack.push_back(src);
+                break;
+            default:
+                break;
+            }
+        }
+        if (isObject && !storesDemanded)
+        {
+            storesDemanded = true;
+            stack.insert(stack.end(), storePtrs.begin(), storePtrs.end());
+        }
+    }
+
+    // Predecessors demanded by earlier queries already hold sets that have not flowed into the
+    // new nodes: copy them over, and push the others again with their whole set
+    for (SVF::NodeID x : newNodes)
+    {
+        for (auto edge : consg->getConstraintNode(x)->getInEdges())
+        {
+            SVF::NodeID src = edge->getSrcID();
+            auto edgeKind = edge->getEdgeKind();
+            if (edgeKind == SVF::ConstraintEdge::Addr || edgeKind == SVF::ConstraintEdge::Store ||
+                pts.getPts(src).empty())
+                continue;
+            if (edgeKind == SVF::ConstraintEdge::Copy)
+            {
+                if (propagate(x, src))
+                    worklist.push(x);
+            }
+            else
+            {
+                diffPts.unionPts(src, pts.getPts(src));
+                worklist.push(src);
+            }
+        }
+    }
+    // Stores whose pointers already reached the new nodes fire now
+    for (SVF::NodeID o : newNodes)
+    {
+        auto it = pendingStores.find(o);
+        if (it == pendingStores.end())
+            continue;
+        for (SVF::NodeID p : it->second)
+        {
+            diffPts.addPts(p, o);
+            worklist.push(p);
+        }
+        pendingStores.erase(it);
+    }
+}
@@ -0,0 +1,145 @@
+/**
+ * FieldCollapse.cpp
+ * @author kisslune
+ */
+
+#include "A5Header.h"
+
+void Andersen::detectPWCs()
+{
+    // A gep edge whose ends share an SCC over copy and gep edges closes a cycle that adds an
+    // offset on every turn: the objects flowing around it would get ever more field objects.
+    // Copy edges derived while solving can close further cycles; the field limit bounds those.
+    unsigned kindMask = (1u << SVF::ConstraintEdge::Copy) | (1u << SVF::ConstraintEdge::NormalGep) |
+                        (1u << SVF::ConstraintEdge::VariantGep);
+    std::vector<unsigned> sccOf;
+    computeSCCs(kindMask, sccOf);
+    for (SVF::NodeID n = 0; n < csr.numNodes(); ++n)
+    {
+        for (const GepRef &gep : csr.getGepSuccs(n))
+        {
+            if (sccOf[n] == sccOf[gep.dst])
+                pwcEdges.insert(gep.edge);
+        }
+    }
+}
+
+
+SVF::NodeID Andersen::getBoundedFieldObj(SVF::NodeID obj, const GepRef &gep)
+{
+    SVF::NodeID base = consg->getFIObjVar(obj);
+    if (collapsedBases.count(base))
+        return base;
+
+    // The fields are merged into the base once the current node is done; until then every
+    // lookup on the base already yields the base
+    auto collapse = [&]() {
+        collapsedBases.insert(base);
+        pendingCollapses.push_back(base);
+        return base;
+    };
+    if (collapseAllFields || (collapsePWC && pwcEdges.count(gep.edge)))
+        return collapse();
+
+    uint64_t misses = fieldCache.getNumMisses();
+    SVF::NodeID fieldObj = fieldCache.get(consg, obj, gep);
+    if (fieldCache.getNumMisses() == misses || fieldObj == base || !trackedFields.insert(fieldObj).second)
+        return fieldObj;
+    if (++numFieldObjs[base] > fieldLimit && fieldLimit)
+        return collapse();
+    return fieldObj;
+}
+
+
+void Andersen::applyCollapses(std::vector<SVF::NodeID> &changed)
+{
+    // Each field object is merged into its base, constraints and points-to set, and is then
+    // replaced by the location representative of its base. A field that shares its location
+    // class with objects of another base stays in the sets next to it.
+    PointsToSet fieldSet;
+    PointsToSet removable;
+    std::unordered_map<SVF::NodeID, SVF::NodeID> baseOf;
+    for (SVF::NodeID base : pendingCollapses)
+    {
+        SVF::NodeID baseRep = getRep(base);
+        SVF::NodeID baseLoc = getLocRep(base);
+        bool merged = false;
+        bool hasFields = false;
+        for (SVF::NodeID field : consg->getAllFieldsObjVars(base))
+        {
+            if (field == base)
+                continue;
+            ++numCollapsedFields;
+            hasFields = true;
+            SVF::NodeID rep = getRep(field);
+            if (rep != baseRep)
+            {
+                mergeNodes(baseRep, rep);
+                merged = true;
+            }
+            SVF::NodeID loc = getLocRep(field);
+            if (loc == baseLoc)
+                continue;
+            fieldSet.set(loc);
+            baseOf[loc] = baseLoc;
+            bool sameBase = true;
+            for (SVF::NodeID member : getLocMembers(loc))
+                sameBase = sameBase && consg->getFIObjVar(member) == base;
+            if (sameBase)
+                removable.set(loc);
+        }
+        if (merged)
+            changed.push_back(baseRep);
+        if (hasFields && collapseAllFields)
+            degradedNodes.emplace_back(base, FieldsMerged);
+        numFieldObjs.erase(base);
+    }
+    pendingCollapses.clear();
+    if (!fieldSet.empty())
+        replaceObjects(fieldSet, baseOf, removable, changed);
+}
+
+
+void Andersen::replaceObjects(const PointsToSet &objs, const std::unordered_map<SVF::NodeID, SVF::NodeID> &replacement,
+                              const PointsToSet &removable, std::vector<SVF::NodeID> &changed)
+{
+    // Pending deltas are rewritten too, or the old objects would flow on from them
+    PointsToSet set;
+    PointsToSet added;
+    auto rewrite = [&](SVF::NodeID n, bool isDelta) {
+        const PointsToSet &old = isDelta ? diffPts.getPts(n) : pts.getPts(n);
+        if (!old.intersects(objs))
+            return;
+        added.clear();
+        for (SVF::NodeID o : old)
+        {
+            if (objs.test(o))
+                added.set(replacement.at(o));
+        }
+        set = old;
+        set.subtract(removable);
+        set.unionWith(added);
+        if (isDelta)
+        {
+            diffPts.clearPts(n);
+            diffPts.unionPts(n, set);
+            return;
+        }
+        added.subtract(old);
+        pts.clearPts(n);
+        pts.unionPts(n, set);
+        if (!added.empty())
+        {
+            diffPts.unionPts(n, added);
+            changed.push_back(n);
+        }
+    };
+    SVF::NodeID numIds = getNumSolvedIds();
+    for (SVF::NodeID n = 0; n < numIds; ++n)
+    {
+        if (getRep(n) != n)
+            continue;
+        rewrite(n, true);
+        rewrite(n, false);
+    }
+}
@@ -0,0 +1,597 @@
+/**
+ * Incremental.cpp
+ * @author kisslune
+ */
+
+#include "A5Header.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+const uint64_t StateMagic = 0x3176535450354131ull;    // "A5PTSv1"
+
+/// FNV-1a over the node count and the sorted edges
+uint64_t fingerprint(SVF::NodeID numIds, const std::vector<StaticEdge> &edges)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint64_t value) {
+        for (unsigned i = 0; i < 8; ++i)
+        {
+            hash ^= (value >> (8 * i)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    };
+    mix(numIds);
+    for (const StaticEdge &edge : edges)
+    {
+        mix(edge.kind);
+        mix(edge.src);
+        mix(edge.dst);
+        mix((uint64_t) edge.offset);
+    }
+    return hash;
+}
+
+/// Fixed-width binary fields of the state file
+class StateWriter
+{
+public:
+    explicit StateWriter(std::ofstream &out) : out(out)
+    {}
+
+    template<class T>
+    inline void write(T value)
+    { out.write(reinterpret_cast<const char *>(&value), sizeof(T)); }
+
+private:
+    std::ofstream &out;
+};
+
+class StateReader
+{
+public:
+    explicit StateReader(std::ifstream &in) : in(in)
+    {
+        in.seekg(0, std::ios::end);
+        size = in.tellg();
+        in.seekg(0, std::ios::beg);
+    }
+
+    /// Read a value, returns false at the end of the file or on a read error
+    template<class T>
+    inline bool read(T &value)
+    { return (bool) in.read(reinterpret_cast<char *>(&value), sizeof(T)); }
+
+    /// Whether the rest of the file can hold count records of recordBytes each; a count read
+    /// from a corrupt file must not size a vector
+    inline bool fits(uint64_t count, uint64_t recordBytes)
+    {
+        std::streamoff pos = in.tellg();
+        return pos >= 0 && pos <= size && count <= (uint64_t) (size - pos) / recordBytes;
+    }
+
+private:
+    std::ifstream &in;
+    std::streamoff size;
+};
+
+/// The state of the previous run, as read from the file
+struct SavedState
+{
+    SVF::NodeID numIds = 0;
+    uint64_t fingerprint = 0;
+    std::vector<StaticEdge> edges;
+    std::vector<FieldObjCache::Resolution> resolutions;
+    std::vector<std::pair<SVF::NodeID, std::vector<SVF::NodeID>>> pts;
+    std::vector<std::pair<SVF::NodeID, SVF::NodeID>> derived;
+    std::vector<std::pair<SVF::NodeID, std::vector<SVF::NodeID>>> pending;   ///< deltas of a run that ran out of budget
+    std::vector<std::pair<SVF::NodeID, SVF::NodeID>> merged;     ///< (node, rep) of merged nodes
+};
+
+bool readState(const std::string &path, SavedState &state)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    StateReader reader(in);
+    uint64_t magic, count;
+    if (!reader.read(magic) || magic != StateMagic || !reader.read(state.numIds) ||
+        !reader.read(state.fingerprint))
+        return false;
+
+    const uint64_t edgeBytes = sizeof(StaticEdge::kind) + sizeof(StaticEdge::src) + sizeof(StaticEdge::dst) +
+                               sizeof(StaticEdge::offset);
+    if (!reader.read(count) || !reader.fits(count, edgeBytes))
+        return false;
+    state.edges.resize(count);
+    for (StaticEdge &edge : state.edges)
+    {
+        if (!reader.read(edge.kind) || !reader.read(edge.src) || !reader.read(edge.dst) || !reader.read(edge.offset))
+            return false;
+    }
+
+    const uint64_t resolutionBytes = 2 * sizeof(SVF::NodeID) + sizeof(SVF::APOffset) + sizeof(uint8_t);
+    if (!reader.read(count) || !reader.fits(count, resolutionBytes))
+        return false;
+    state.resolutions.resize(count);
+    for (FieldObjCache::Resolution &res : state.resolutions)
+    {
+        uint8_t variant;
+        if (!reader.read(res.obj) || !reader.read(res.offset) || !reader.read(variant) || !reader.read(res.fieldObj))
+            return false;
+        res.variant = variant != 0;
+    }
+
+    // A set is its node, its size and its objects
+    const uint64_t setBytes = sizeof(SVF::NodeID) + sizeof(uint32_t);
+    if (!reader.read(count) || !reader.fits(count, setBytes))
+        return false;
+    state.pts.resize(count);
+    for (auto &entry : state.pts)
+    {
+        uint32_t size;
+        if (!reader.read(entry.first) || !reader.read(size) || !reader.fits(size, sizeof(SVF::NodeID)))
+            return false;
+        entry.second.resize(size);
+        for (SVF::NodeID &obj : entry.second)
+        {
+            if (!reader.read(obj))
+                return false;
+        }
+    }
+
+    const uint64_t pairBytes = 2 * sizeof(SVF::NodeID);
+    if (!reader.read(count) || !reader.fits(count, pairBytes))
+        return false;
+    state.derived.resize(count);
+    for (auto &edge : state.derived)
+    {
+        if (!reader.read(edge.first) || !reader.read(edge.second))
+            return false;
+    }
+
+    // Files written before budgets existed end here
+    if (!reader.read(count))
+        return true;
+    if (!reader.fits(count, setBytes))
+        return false;
+    state.pending.resize(count);
+    for (auto &entry : state.pending)
+    {
+        uint32_t size;
+        if (!reader.read(entry.first) || !reader.read(size) || !reader.fits(size, sizeof(SVF::NodeID)))
+            return false;
+        entry.second.resize(size);
+        for (SVF::NodeID &obj : entry.second)
+        {
+            if (!reader.read(obj))
+                return false;
+        }
+    }
+
+    if (!reader.read(count) || !reader.fits(count, pairBytes))
+        return false;
+    state.merged.resize(count);
+    for (auto &entry : state.merged)
+    {
+        if (!reader.read(entry.first) || !reader.read(entry.second))
+            return false;
+    }
+    return true;
+}
+}
+
+
+void Andersen::collectStaticEdges(std::vector<StaticEdge> &edges)
+{
+    numStaticIds = 0;
+    for (auto const& iter : *consg)
+    {
+        numStaticIds = std::max(numStaticIds, iter.first + 1);
+        for (auto edge : iter.second->getOutEdges())
+        {
+            auto edgeKind = edge->getEdgeKind();
+            int64_t offset = 0;
+            if (auto normalGep = llvm::dyn_cast<SVF::NormalGepCGEdge>(edge))
+                offset = normalGep->getConstantFieldIdx();
+            edges.push_back({(uint32_t) edgeKind, edge->getSrcID(), edge->getDstID(), offset});
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+}
+
+
+bool Andersen::resumeFromState(const std::vector<StaticEdge> &edges, std::vector<SVF::NodeID> &initial)
+{
+    SavedState saved;
+    if (!readState(stateFile, saved))
+    {
+        resumeSummary = "no usable state in " + stateFile + ", solving from scratch";
+        return false;
+    }
+    // Node IDs are the identity between runs, so a graph that lost nodes cannot be matched
+    if (saved.numIds > numStaticIds)
+    {
+        resumeSummary = "nodes were removed, solving from scratch";
+        return false;
+    }
+
+    // -------------------------------------------------------
+    // 1. Edge diff
+    // -------------------------------------------------------
+    std::vector<StaticEdge> added;
+    std::vector<StaticEdge> deleted;
+    if (saved.numIds != numStaticIds || saved.fingerprint != fingerprint(numStaticIds, edges))
+    {
+        std::set_difference(edges.begin(), edges.end(), saved.edges.begin(), saved.edges.end(),
+                            std::back_inserter(added));
+        std::set_difference(saved.edges.begin(), saved.edges.end(), edges.begin(), edges.end(),
+                            std::back_inserter(deleted));
+    }
+
+    // -------------------------------------------------------
+    // 2. Recreate the field objects of the previous run and map their old IDs to the new ones
+    // -------------------------------------------------------
+    std::vector<SVF::NodeID> remap(saved.numIds);
+    for (SVF::NodeID n = 0; n < saved.numIds; ++n)
+        remap[n] = n;
+    auto mapId = [&remap](SVF::NodeID old) {
+        return old < remap.size() ? remap[old] : ~0u;
+    };
+    // A lookup must be on an object, the source of an Addr edge or a field object recreated
+    // before it, and its field object must map back to the one saved: the same static node, or
+    // a field object no other saved ID maps to. Otherwise the file is not from this graph.
+    std::vector<bool> isObject(numStaticIds, false);
+    for (const StaticEdge &edge : edges)
+    {
+        if (edge.kind == SVF::ConstraintEdge::Addr)
+            isObject[edge.src] = true;
+    }
+    std::unordered_map<SVF::NodeID, SVF::NodeID> savedIdOf;
+    for (const FieldObjCache::Resolution &res : saved.resolutions)
+    {
+        SVF::NodeID obj = mapId(res.obj);
+        bool consistent = obj != ~0u && obj < isObject.size() && isObject[obj] && consg->hasConstraintNode(obj);
+        SVF::NodeID fieldObj = ~0u;
+        if (consistent)
+        {
+            fieldObj = res.variant ? consg->getFIObjVar(obj) : consg->getGepObjVar(obj, res.offset);
+            SVF::NodeID mapped = mapId(res.fieldObj);
+            consistent = (mapped == ~0u || mapped == fieldObj) &&
+                         savedIdOf.emplace(fieldObj, res.fieldObj).first->second == res.fieldObj;
+        }
+        if (!consistent)
+        {
+            resumeSummary = "inconsistent field objects in " + stateFile + ", solving from scratch";
+            return false;
+        }
+        fieldCache.insert(obj, res.offset, res.variant, fieldObj);
+        if (res.fieldObj >= remap.size())
+            remap.resize(res.fieldObj + 1, ~0u);
+        remap[res.fieldObj] = fieldObj;
+        if (fieldObj >= isObject.size())
+            isObject.resize(fieldObj + 1, false);
+        isObject[fieldObj] = true;
+    }
+
+    SVF::NodeID numIds = 0;
+    for (auto const& iter : *consg)
+        numIds = std::max(numIds, iter.first + 1);
+    DensePtsMap<PointsToSet> oldPts;
+    oldPts.reserve(numIds);
+    for (auto const& entry : saved.pts)
+    {
+        SVF::NodeID n = mapId(entry.first);
+        for (SVF::NodeID obj : entry.second)
+        {
+            if (n == ~0u || mapId(obj) == ~0u)
+            {
+                resumeSummary = "inconsistent points-to sets in " + stateFile + ", solving from scratch";
+                return false;
+            }
+            oldPts.addPts(n, mapId(obj));
+        }
+    }
+    std::vector<std::vector<SVF::NodeID>> oldDerived(numIds);
+    for (auto const& edge : saved.derived)
+    {
+        SVF::NodeID src = mapId(edge.first);
+        SVF::NodeID dst = mapId(edge.second);
+        if (src == ~0u || dst == ~0u)
+        {
+            resumeSummary = "inconsistent copy edges in " + stateFile + ", solving from scratch";
+            return false;
+        }
+        oldDerived[src].push_back(dst);
+    }
+
+    // -------------------------------------------------------
+    // 3. Nodes whose sets may shrink: everything the deleted edges flowed into
+    // -------------------------------------------------------
+    // A node is affected if it was fed by a deleted edge or by an affected node, either directly or
+    // through a derived copy edge; a derived edge whose store or load pointer is affected may vanish,
+    // so the objects pointed-to by an affected store pointer and the results of its loads are too.
+    std::vector<bool> affected(numIds, false);
+    std::vector<SVF::NodeID> affectedNodes;
+    const size_t limit = (size_t) (maxInvalidation * numStaticIds);
+    auto markAffected = [&](SVF::NodeID n) {
+        if (!affected[n])
+        {
+            affected[n] = true;
+            affectedNodes.push_back(n);
+        }
+    };
+    for (const StaticEdge &edge : deleted)
+    {
+        if (edge.kind == SVF::ConstraintEdge::Store)
+        {
+            for (SVF::NodeID obj : oldPts.getPts(edge.dst))
+                markAffected(obj);
+        }
+        else
+            markAffected(edge.dst);
+    }
+    std::vector<SVF::NodeID> storePtrs;
+    for (size_t i = 0; i < affectedNodes.size(); ++i)
+    {
+        if (affectedNodes.size() > limit)
+        {
+            resumeSummary = "more than " + std::to_string(limit) + " nodes invalidated, solving from scratch";
+            return false;
+        }
+        SVF::NodeID n = affectedNodes[i];
+        for (SVF::NodeID dst : csr.getCopySuccs(n))
+            markAffected(dst);
+        for (SVF::NodeID dst : csr.getLoadSuccs(n))
+            markAffected(dst);
+        for (const GepRef &gep : csr.getGepSuccs(n))
+            markAffected(gep.dst);
+        for (SVF::NodeID dst : oldDerived[n])
+            markAffected(dst);
+        if (!csr.getStoreSrcs(n).empty())
+        {
+            for (SVF::NodeID obj : oldPts.getPts(n))
+                markAffected(obj);
+        }
+    }
+
+    // -------------------------------------------------------
+    // 4. Restore the unaffected sets and the derived edges into them
+    // -------------------------------------------------------
+    pts.reserve(numIds);
+    diffPts.reserve(numIds);
+    for (SVF::NodeID n = 0; n < numIds; ++n)
+    {
+        if (!affected[n] && !oldPts.getPts(n).empty())
+            pts.unionPts(n, oldPts.getPts(n));
+    }
+    std::vector<std::pair<SVF::NodeID, SVF::NodeID>> dropped;
+    for (SVF::NodeID src = 0; src < numIds; ++src)
+    {
+        for (SVF::NodeID dst : oldDerived[src])
+        {
+            if (affected[dst])
+                dropped.emplace_back(src, dst);
+            else
+                addDerivedCopyEdge(src, dst);
+        }
+    }
+
+    // -------------------------------------------------------
+    // 5. Seed the worklist: everything that feeds an affected node or uses an added edge
+    // -------------------------------------------------------
+    auto seedAll = [&](SVF::NodeID n) {
+        if (affected[n] || pts.getPts(n).empty())
+            return;
+        diffPts.unionPts(n, pts.getPts(n));
+        initial.push_back(n);
+    };
+    auto seedObj = [&](SVF::NodeID p, SVF::NodeID o) {
+        if (pts.addPts(p, o))
+        {
+            diffPts.addPts(p, o);
+            initial.push_back(p);
+        }
+    };
+    for (SVF::NodeID a : affectedNodes)
+    {
+        if (!consg->hasConstraintNode(a))
+            continue;
+        for (auto edge : consg->getConstraintNode(a)->getInEdges())
+        {
+            auto edgeKind = edge->getEdgeKind();
+            if (edgeKind == SVF::ConstraintEdge::Addr)
+                seedObj(a, edge->getSrcID());
+            else if (edgeKind != SVF::ConstraintEdge::Store)
+                seedAll(edge->getSrcID());
+        }
+    }
+    // Dropped edges come back if the store or load that derived them still does
+    for (auto const& edge : dropped)
+    {
+        for (auto e : consg->getConstraintNode(edge.first)->getOutEdges())
+        {
+            if (e->getEdgeKind() == SVF::ConstraintEdge::Store)
+                seedAll(e->getDstID());
+        }
+        for (auto e : consg->getConstraintNode(edge.second)->getInEdges())
+        {
+            if (e->getEdgeKind() == SVF::ConstraintEdge::Load)
+                seedAll(e->getSrcID());
+        }
+    }
+    for (const StaticEdge &edge : added)
+    {
+        if (edge.kind == SVF::ConstraintEdge::Addr)
+            seedObj(edge.dst, edge.src);
+        else if (edge.kind == SVF::ConstraintEdge::Store)
+            seedAll(edge.dst);
+        else
+            seedAll(edge.src);
+    }
+
+    // -------------------------------------------------------
+    // 6. Continue a run that stopped before the fixpoint
+    // -------------------------------------------------------
+    // On an unchanged graph the merges of the previous run still hold, and their edges have seen
+    // the merged sets: restore them without pushing the sets again, or every slice of a budgeted
+    // analysis would start over. The pending deltas are then the only work left.
+    if (added.empty() && deleted.empty())
+    {
+        for (auto const& entry : saved.merged)
+        {
+            SVF::NodeID n = mapId(entry.first);
+            SVF::NodeID rep = mapId(entry.second);
+            if (n != ~0u && rep != ~0u && getRep(n) != getRep(rep))
+                mergeNodes(getRep(rep), getRep(n));
+        }
+        for (SVF::NodeID n = 0; n < diffPts.size(); ++n)
+            diffPts.clearPts(n);
+        initial.clear();
+    }
+    // Deltas the previous run had no budget left for, in the order it would have processed them
+    size_t numPending = 0;
+    for (auto const& entry : saved.pending)
+    {
+        SVF::NodeID n = mapId(entry.first);
+        if (n == ~0u || affected[n])
+            continue;
+        SVF::NodeID rep = getRep(n);
+        bool any = false;
+        for (SVF::NodeID obj : entry.second)
+        {
+            if (mapId(obj) != ~0u && pts.getPts(rep).test(mapId(obj)))
+                any = diffPts.addPts(rep, mapId(obj)) || any;
+        }
+        if (any)
+        {
+            initial.push_back(rep);
+            ++numPending;
+        }
+    }
+
+    if (added.empty() && deleted.empty())
+        resumeSummary = "constraint graph unchanged, state restored";
+    else
+        resumeSummary = "resumed: " + std::to_string(added.size()) + " edges added, " +
+                        std::to_string(deleted.size()) + " deleted, " +
+                        std::to_string(affectedNodes.size()) + " nodes invalidated";
+    if (numPending)
+        resumeSummary += ", " + std::to_string(numPending) + " pending nodes resumed";
+    return true;
+}
+
+
+void Andersen::saveState(const std::vector<StaticEdge> &edges)
+{
+    // Write to a temporary file first so that an interrupted run keeps the previous state
+    std::string tmpFile = stateFile + ".tmp";
+    {
+        std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "error opening " + tmpFile + "!!\n";
+            return;
+        }
+        StateWriter writer(out);
+        writer.write(StateMagic);
+        writer.write(numStaticIds);
+        writer.write(fingerprint(numStaticIds, edges));
+
+        writer.write((uint64_t) edges.size());
+        for (const StaticEdge &edge : edges)
+        {
+            writer.write(edge.kind);
+            writer.write(edge.src);
+            writer.write(edge.dst);
+            writer.write(edge.offset);
+        }
+
+        const auto &resolutions = fieldCache.getResolutions();
+        writer.write((uint64_t) resolutions.size());
+        for (const FieldObjCache::Resolution &res : resolutions)
+        {
+            writer.write(res.obj);
+            writer.write((int64_t) res.offset);
+            writer.write((uint8_t) res.variant);
+            writer.write(res.fieldObj);
+        }
+
+        // Sets are written per original node, with location classes expanded
+        SVF::NodeID numIds = std::max(pts.size(), repOf.size());
+        PointsToSet scratch;
+        uint64_t numSets = 0;
+        for (SVF::NodeID n = 0; n < numIds; ++n)
+            numSets += !pts.getPts(getRep(n)).empty();
+        writer.write(numSets);
+        for (SVF::NodeID n = 0; n < numIds; ++n)
+        {
+            const PointsToSet &set = getExpandedPts(n, scratch);
+            if (set.empty())
+                continue;
+            writer.write(n);
+            writer.write((uint32_t) set.size());
+            for (SVF::NodeID obj : set)
+                writer.write(obj);
+        }
+
+        // A derived edge from or to a location representative stands for one per object of its class
+        std::vector<std::pair<SVF::NodeID, SVF::NodeID>> derived;
+        for (SVF::NodeID n = 0; n < csr.numOverflowRows(); ++n)
+        {
+            for (SVF::NodeID dst : csr.getNewCopySuccs(n))
+            {
+                for (SVF::NodeID src : getLocMembers(n))
+                {
+                    for (SVF::NodeID obj : getLocMembers(dst))
+                        derived.emplace_back(src, obj);
+                }
+            }
+        }
+        writer.write((uint64_t) derived.size());
+        for (auto const& edge : derived)
+        {
+            writer.write(edge.first);
+            writer.write(edge.second);
+        }
+
+        // Pending deltas, per original node like the sets, if the run stopped before the fixpoint
+        uint64_t numPending = 0;
+        for (SVF::NodeID rep : pendingNodes)
+            numPending += getMembers(rep).size();
+        writer.write(numPending);
+        for (SVF::NodeID rep : pendingNodes)
+        {
+            scratch.clear();
+            for (SVF::NodeID o : diffPts.getPts(rep))
+            {
+                for (SVF::NodeID obj : getLocMembers(o))
+                    scratch.set(obj);
+            }
+            for (SVF::NodeID n : getMembers(rep))
+            {
+                writer.write(n);
+                writer.write((uint32_t) scratch.size());
+                for (SVF::NodeID obj : scratch)
+                    writer.write(obj);
+            }
+        }
+
+        // Merged nodes, restored by a run that continues this one on the same graph
+        std::vector<std::pair<SVF::NodeID, SVF::NodeID>> merged;
+        for (SVF::NodeID n = 0; n < repOf.size(); ++n)
+        {
+            if (getRep(n) != n)
+                merged.emplace_back(n, getRep(n));
+        }
+        writer.write((uint64_t) merged.size());
+        for (auto const& entry : merged)
+        {
+            writer.write(entry.first);
+            writer.write(entry.second);
+        }
+    }
+    std::rename(tmpFile.c_str(), stateFile.c_str());
+}
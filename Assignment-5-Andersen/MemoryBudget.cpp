@@ -0,0 +1,250 @@
+/**
+ * MemoryBudget.cpp
+ * @author kisslune
+ */
+
+#include "A5Header.h"
+
+namespace
+{
+/// Fraction of the budget at which the solver degrades one stage further
+const double DegradeThreshold = 0.75;
+
+/// Sets with more objects than this are merged into the summary object of stage 2
+const size_t SummarySetSize = 64;
+}
+
+
+size_t Andersen::getPtsMemory() const
+{
+    return pts.memoryUsage() + diffPts.memoryUsage() + complexDone.memoryUsage();
+}
+
+
+bool Andersen::checkMemoryBudget(std::vector<SVF::NodeID> &changed)
+{
+    if (getPtsMemory() < DegradeThreshold * memoryBudget)
+        return false;
+
+    // Each stage gives up more precision than the one before, and the last one always fits
+    switch (degradeStage)
+    {
+    case NotDegraded:
+        degradeStage = FieldsMerged;
+        mergeAllFields(changed);
+        return false;
+    case FieldsMerged:
+        degradeStage = SetsSummarised;
+        summariseLargeSets(changed);
+        return false;
+    default:
+        degradeStage = Unified;
+        unifyAll();
+        return true;
+    }
+}
+
+
+void Andersen::mergeAllFields(std::vector<SVF::NodeID> &changed)
+{
+    // Bases collapse like those past the field limit; later gep lookups collapse any other base
+    collapseAllFields = true;
+    for (const FieldObjCache::Resolution &res : fieldCache.getResolutions())
+    {
+        SVF::NodeID base = consg->getFIObjVar(res.fieldObj);
+        if (res.fieldObj != base && collapsedBases.insert(base).second)
+            pendingCollapses.push_back(base);
+    }
+    applyCollapses(changed);
+}
+
+
+void Andersen::summariseLargeSets(std::vector<SVF::NodeID> &changed)
+{
+    // The objects of all large sets become one location class, as if they were one object: its
+    // node holds what any of them points to, and the result lists every member
+    SVF::NodeID numIds = getNumSolvedIds();
+    PointsToSet objs;
+    for (SVF::NodeID n = 0; n < numIds; ++n)
+    {
+        if (getRep(n) == n && pts.getPts(n).size() > SummarySetSize)
+            objs.unionWith(pts.getPts(n));
+    }
+    if (objs.size() < 2)
+        return;
+
+    SVF::NodeID summary = *objs.begin();
+    objs.reset(summary);
+    if (locRepOf.size() < numIds)
+    {
+        SVF::NodeID old = locRepOf.size();
+        locRepOf.resize(numIds);
+        for (SVF::NodeID o = old; o < numIds; ++o)
+            locRepOf[o] = o;
+    }
+    std::vector<SVF::NodeID> &members = locMembers[summary];
+    if (members.empty())
+        members.push_back(summary);
+    degradedNodes.emplace_back(summary, SetsSummarised);
+
+    std::unordered_map<SVF::NodeID, SVF::NodeID> replacement;
+    for (SVF::NodeID o : objs)
+    {
+        std::vector<SVF::NodeID> objMembers(getLocMembers(o).begin(), getLocMembers(o).end());
+        for (SVF::NodeID member : objMembers)
+        {
+            locRepOf[member] = summary;
+            members.push_back(member);
+            degradedNodes.emplace_back(member, SetsSummarised);
+        }
+        locMembers.erase(o);
+        SVF::NodeID summaryRep = getRep(summary);
+        SVF::NodeID rep = getRep(o);
+        if (rep != summaryRep)
+            mergeNodes(summaryRep, rep);
+        replacement[o] = summary;
+    }
+    changed.push_back(getRep(summary));
+    replaceObjects(objs, replacement, objs, changed);
+}
+
+
+void Andersen::unifyAll()
+{
+    // Steensgaard-style unification: every class of nodes has at most one pointee class, and each
+    // constraint joins classes instead of adding subset edges. The result over-approximates the
+    // inclusion-based one, takes linear space, and replaces whatever the solver had so far.
+    SVF::NodeID numIds = 0;
+    for (auto const& iter : *consg)
+        numIds = std::max(numIds, iter.first + 1);
+    const SVF::NodeID none = ~0u;
+    std::vector<SVF::NodeID> parent(numIds);
+    for (SVF::NodeID n = 0; n < numIds; ++n)
+        parent[n] = n;
+    std::vector<SVF::NodeID> pointee(numIds, none);
+
+    auto find = [&](SVF::NodeID n) {
+        while (parent[n] != n)
+        {
+            parent[n] = parent[parent[n]];
+            n = parent[n];
+        }
+        return n;
+    };
+    std::vector<std::pair<SVF::NodeID, SVF::NodeID>> joins;
+    auto join = [&](SVF::NodeID a, SVF::NodeID b) {
+        joins.emplace_back(a, b);
+        while (!joins.empty())
+        {
+            SVF::NodeID x = find(joins.back().first);
+            SVF::NodeID y = find(joins.back().second);
+            joins.pop_back();
+            if (x == y)
+                continue;
+            parent[y] = x;
+            if (pointee[y] == none)
+                continue;
+            if (pointee[x] == none)
+                pointee[x] = pointee[y];
+            else
+                joins.emplace_back(pointee[x], pointee[y]);
+        }
+    };
+    // The pointee class of n, made up if it has none yet
+    auto deref = [&](SVF::NodeID n) {
+        n = find(n);
+        if (pointee[n] == none)
+        {
+            pointee[n] = parent.size();
+            parent.push_back(parent.size());
+            pointee.push_back(none);
+        }
+        return pointee[n];
+    };
+
+    // Objects are taken field-insensitively, as the copy-like treatment of geps requires
+    std::vector<bool> isObject(numIds, false);
+    auto addObject = [&](SVF::NodeID o) {
+        isObject[o] = true;
+        SVF::NodeID base = consg->getFIObjVar(o);
+        isObject[base] = true;
+        join(base, o);
+    };
+    for (const FieldObjCache::Resolution &res : fieldCache.getResolutions())
+        addObject(res.fieldObj);
+    for (auto const& iter : *consg)
+    {
+        for (auto edge : iter.second->getOutEdges())
+        {
+            SVF::NodeID src = edge->getSrcID();
+            SVF::NodeID dst = edge->getDstID();
+            switch (edge->getEdgeKind())
+            {
+            case SVF::ConstraintEdge::Addr:
+                addObject(src);
+                join(deref(dst), src);
+                break;
+            case SVF::ConstraintEdge::Copy:
+            case SVF::ConstraintEdge::NormalGep:
+            case SVF::ConstraintEdge::VariantGep:
+                join(deref(dst), deref(src));
+                break;
+            case SVF::ConstraintEdge::Load:
+                join(deref(dst), deref(deref(src)));
+                break;
+            case SVF::ConstraintEdge::Store:
+                join(deref(deref(dst)), deref(src));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    // Nodes the solver merged share one set, and so must their classes
+    for (SVF::NodeID n = 0; n < numIds; ++n)
+    {
+        if (getRep(n) != n)
+            join(deref(n), deref(getRep(n)));
+        if (getLocRep(n) != n)
+            join(n, getLocRep(n));
+    }
+
+    // -------------------------------------------------------
+    // Each class of objects becomes a location class, which every pointer to it points to
+    // -------------------------------------------------------
+    std::unordered_map<SVF::NodeID, SVF::NodeID> classObj;    // class -> its smallest object
+    locRepOf.resize(numIds);
+    locMembers.clear();
+    for (SVF::NodeID o = 0; o < numIds; ++o)
+    {
+        locRepOf[o] = o;
+        if (!isObject[o])
+            continue;
+        SVF::NodeID rep = classObj.emplace(find(o), o).first->second;
+        locRepOf[o] = rep;
+        if (rep == o)
+            continue;
+        std::vector<SVF::NodeID> &members = locMembers[rep];
+        if (members.empty())
+            members.push_back(rep);
+        members.push_back(o);
+    }
+    SVF::NodeID numSolvedIds = getNumSolvedIds();
+    for (SVF::NodeID n = 0; n < numSolvedIds; ++n)
+    {
+        diffPts.clearPts(n);
+        if (getRep(n) != n)
+            continue;
+        pts.clearPts(n);
+        if (n >= numIds || pointee[find(n)] == none)
+            continue;
+        auto cls = classObj.find(find(pointee[find(n)]));
+        if (cls != classObj.end())
+            pts.addPts(n, cls->second);
+    }
+    for (SVF::NodeID n = 0; n < numSolvedIds; ++n)
+    {
+        if (!pts.getPts(getRep(n)).empty())
+            degradedNodes.emplace_back(n, Unified);
+    }
+}
@@ -0,0 +1,189 @@
+/**
+ * OfflineReduction.cpp
+ * @author kisslune
+ */
+
+#include "A5Header.h"
+
+#include <limits>
+#include <map>
+#include <set>
+
+namespace
+{
+/// Hashes label sets by content
+struct LabelSetHash
+{
+    size_t operator()(const PointsToSet &labels) const
+    { return labels.hash(); }
+};
+}
+
+
+void Andersen::reduceOffline()
+{
+    // Hash-based value numbering with hash-union (HVN/HU) over the static constraints.
+    // Every pointer gets the set of "primitive labels" its points-to set is built from:
+    //  - ADR(o) for each o -Addr-> p,
+    //  - a fresh label for nodes the solver feeds through derived copy edges (objects and load
+    //    results), whose sets are unknown offline,
+    //  - GEP(v, offset) for a gep from a pointer with label set v,
+    //  - the labels of all copy predecessors.
+    // Pointers with equal non-empty label sets end up with equal points-to sets and are merged.
+    // Objects with no static in-edges, only Addr out-edges and the same Addr destinations are
+    // always pointed-to together (location equivalence): points-to sets hold only the first of
+    // them, and dumpResult expands it again.
+    std::vector<SVF::NodeID> nodes;
+    for (auto const& iter : *consg)
+        nodes.push_back(iter.first);
+    std::sort(nodes.begin(), nodes.end());
+    SVF::NodeID numIds = nodes.empty() ? 0 : nodes.back() + 1;
+
+    // -------------------------------------------------------
+    // 1. Location equivalence
+    // -------------------------------------------------------
+    std::vector<bool> isObject(numIds, false);
+    std::vector<bool> isIndirect(numIds, false);
+    std::map<std::vector<SVF::NodeID>, SVF::NodeID> locClasses;
+    locRepOf.resize(numIds);
+    for (SVF::NodeID n = 0; n < numIds; ++n)
+        locRepOf[n] = n;
+    for (SVF::NodeID n : nodes)
+    {
+        SVF::ConstraintNode *node = consg->getConstraintNode(n);
+        std::vector<SVF::NodeID> addrDsts;
+        bool onlyAddr = node->getInEdges().empty();
+        for (auto edge : node->getOutEdges())
+        {
+            auto edgeKind = edge->getEdgeKind();
+            if (edgeKind == SVF::ConstraintEdge::Addr)
+                addrDsts.push_back(edge->getDstID());
+            else
+                onlyAddr = false;
+            if (edgeKind == SVF::ConstraintEdge::Load)
+                isIndirect[edge->getDstID()] = true;
+        }
+        if (addrDsts.empty())
+            continue;
+        isObject[n] = isIndirect[n] = true;
+        if (!onlyAddr)
+            continue;
+        std::sort(addrDsts.begin(), addrDsts.end());
+        auto cls = locClasses.emplace(std::move(addrDsts), n).first;
+        if (cls->second != n)
+        {
+            locRepOf[n] = cls->second;
+            auto &members = locMembers[cls->second];
+            if (members.empty())
+                members.push_back(cls->second);
+            members.push_back(n);
+        }
+    }
+
+    // -------------------------------------------------------
+    // 2. Label sets, in topological order of the copy SCCs
+    // -------------------------------------------------------
+    std::vector<unsigned> sccOf;
+    unsigned numSCCs = computeSCCs(1u << SVF::ConstraintEdge::Copy, sccOf);
+    std::vector<std::vector<SVF::NodeID>> sccNodes(numSCCs);
+    for (SVF::NodeID n : nodes)
+        sccNodes[sccOf[n]].push_back(n);
+
+    std::unordered_map<PointsToSet, unsigned, LabelSetHash> valueNumbers;   // label set -> VN, VN 0 is {}
+    std::vector<PointsToSet> sccLabels(numSCCs);
+    std::vector<unsigned> sccVN(numSCCs, 0);
+    std::unordered_map<SVF::NodeID, unsigned> adrLabels;
+    std::unordered_map<SVF::NodeID, unsigned> objLabels;
+    std::map<std::pair<unsigned, SVF::APOffset>, unsigned> gepLabels;
+    unsigned numLabels = 0;
+    valueNumbers.emplace(PointsToSet(), 0);
+
+    auto labelOf = [&numLabels](std::unordered_map<SVF::NodeID, unsigned> &labels, SVF::NodeID key) {
+        auto it = labels.emplace(key, numLabels);
+        if (it.second)
+            ++numLabels;
+        return it.first->second;
+    };
+
+    for (unsigned scc = numSCCs; scc-- > 0;)
+    {
+        PointsToSet &labels = sccLabels[scc];
+        for (SVF::NodeID n : sccNodes[scc])
+        {
+            if (isObject[n])
+                labels.set(labelOf(objLabels, getLocRep(n)));
+            else if (isIndirect[n])
+                labels.set(numLabels++);
+            for (auto edge : consg->getConstraintNode(n)->getInEdges())
+            {
+                SVF::NodeID src = edge->getSrcID();
+                auto edgeKind = edge->getEdgeKind();
+                if (edgeKind == SVF::ConstraintEdge::Addr)
+                    labels.set(labelOf(adrLabels, getLocRep(src)));
+                else if (edgeKind == SVF::ConstraintEdge::Copy && sccOf[src] != scc)
+                    labels.unionWith(sccLabels[sccOf[src]]);
+                else if (edgeKind == SVF::ConstraintEdge::NormalGep || edgeKind == SVF::ConstraintEdge::VariantGep)
+                {
+                    // Geps against the copy order would make the labels depend on themselves
+                    if (sccOf[src] <= scc)
+                    {
+                        labels.set(numLabels++);
+                        continue;
+                    }
+                    unsigned srcVN = sccVN[sccOf[src]];
+                    if (srcVN == 0)
+                        continue;
+                    SVF::APOffset offset = std::numeric_limits<SVF::APOffset>::min();
+                    if (auto normalGep = llvm::dyn_cast<SVF::NormalGepCGEdge>(edge))
+                        offset = normalGep->getConstantFieldIdx();
+                    auto it = gepLabels.emplace(std::make_pair(srcVN, offset), numLabels);
+                    if (it.second)
+                        ++numLabels;
+                    labels.set(it.first->second);
+                }
+            }
+        }
+        auto vn = valueNumbers.emplace(labels, valueNumbers.size());
+        sccVN[scc] = vn.first->second;
+    }
+
+    // -------------------------------------------------------
+    // 3. Merge equivalent nodes
+    // -------------------------------------------------------
+    std::vector<SVF::NodeID> firstOfVN(valueNumbers.size(), ~0u);
+    for (SVF::NodeID n : nodes)
+    {
+        SVF::NodeID rep = n;
+        if (getLocRep(n) != n)
+            rep = getLocRep(n);
+        else if (unsigned vn = sccVN[sccOf[n]])
+        {
+            if (firstOfVN[vn] == ~0u)
+                firstOfVN[vn] = n;
+            rep = firstOfVN[vn];
+        }
+        if (getRep(rep) != getRep(n))
+        {
+            mergeNodes(getRep(rep), getRep(n));
+            ++numReducedNodes;
+        }
+    }
+
+    // Count the edges that became duplicates or self-copies on the merged graph
+    std::set<std::tuple<SVF::GEdgeKind, SVF::NodeID, SVF::NodeID, SVF::APOffset>> keptEdges;
+    for (SVF::NodeID n : nodes)
+    {
+        for (auto edge : consg->getConstraintNode(n)->getOutEdges())
+        {
+            auto edgeKind = edge->getEdgeKind();
+            SVF::NodeID src = edgeKind == SVF::ConstraintEdge::Addr ? getLocRep(n) : getRep(n);
+            SVF::NodeID dst = getRep(edge->getDstID());
+            SVF::APOffset offset = 0;
+            if (auto normalGep = llvm::dyn_cast<SVF::NormalGepCGEdge>(edge))
+                offset = normalGep->getConstantFieldIdx();
+            if ((edgeKind == SVF::ConstraintEdge::Copy && src == dst) ||
+                !keptEdges.emplace(edgeKind, src, dst, offset).second)
+                ++numReducedEdges;
+        }
+    }
+}
@@ -0,0 +1,672 @@
+/**
+ * PointsTo.h
+ * Points-to set representations used by the Andersen solver.
+ */
+
+#ifndef ANSWERS_POINTSTO_H
+#define ANSWERS_POINTSTO_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Word-level kernels over fixed-size bit blocks.
+ * They are plain loops over a compile-time number of words so that the compiler can vectorise them.
+ */
+namespace PtsKernel
+{
+constexpr unsigned BlockWords = 4;
+
+/// dst |= src, returns true if dst changed
+inline bool orInto(uint64_t *dst, const uint64_t *src)
+{
+    uint64_t changed = 0;
+    for (unsigned w = 0; w < BlockWords; ++w)
+    {
+        uint64_t merged = dst[w] | src[w];
+        changed |= merged ^ dst[w];
+        dst[w] = merged;
+    }
+    return changed != 0;
+}
+
+/// dst &= src, returns true if dst changed
+inline bool andInto(uint64_t *dst, const uint64_t *src)
+{
+    uint64_t changed = 0;
+    for (unsigned w = 0; w < BlockWords; ++w)
+    {
+        uint64_t kept = dst[w] & src[w];
+        changed |= kept ^ dst[w];
+        dst[w] = kept;
+    }
+    return changed != 0;
+}
+
+/// dst &= ~src, returns true if dst changed
+inline bool andNotInto(uint64_t *dst, const uint64_t *src)
+{
+    uint64_t changed = 0;
+    for (unsigned w = 0; w < BlockWords; ++w)
+    {
+        uint64_t kept = dst[w] & ~src[w];
+        changed |= kept ^ dst[w];
+        dst[w] = kept;
+    }
+    return changed != 0;
+}
+
+/// Whether (a & b) has any bit set
+inline bool anyAnd(const uint64_t *a, const uint64_t *b)
+{
+    uint64_t any = 0;
+    for (unsigned w = 0; w < BlockWords; ++w)
+        any |= a[w] & b[w];
+    return any != 0;
+}
+
+/// Whether no bit is set
+inline bool isZero(const uint64_t *a)
+{
+    uint64_t any = 0;
+    for (unsigned w = 0; w < BlockWords; ++w)
+        any |= a[w];
+    return any == 0;
+}
+
+/// Number of bits set
+inline unsigned popCount(const uint64_t *a)
+{
+    unsigned n = 0;
+    for (unsigned w = 0; w < BlockWords; ++w)
+        n += __builtin_popcountll(a[w]);
+    return n;
+}
+} // namespace PtsKernel
+
+
+/**
+ * Sparse bitmap: a sorted vector of fixed-size bit blocks, one block per 256 consecutive IDs that has any bit set.
+ * Set operations walk both block vectors in step and combine matching blocks word by word.
+ */
+class SparseBitmap
+{
+public:
+    static constexpr unsigned WordBits = 64;
+    static constexpr unsigned BlockWords = PtsKernel::BlockWords;
+    static constexpr unsigned BlockBits = WordBits * BlockWords;
+
+    struct Block
+    {
+        uint32_t index;     ///< ID / BlockBits
+        uint64_t words[BlockWords];
+    };
+
+    /// Iterates over the set bits in ascending order
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = unsigned;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const unsigned *;
+        using reference = unsigned;
+
+        const_iterator(const Block *cur, const Block *end) : cur(cur), end(end), word(0), bits(0)
+        {
+            if (cur != end)
+            {
+                bits = cur->words[0];
+                settle();
+            }
+        }
+
+        inline unsigned operator*() const
+        { return cur->index * BlockBits + word * WordBits + __builtin_ctzll(bits); }
+
+        inline const_iterator &operator++()
+        {
+            bits &= bits - 1;
+            settle();
+            return *this;
+        }
+
+        inline const_iterator operator++(int)
+        {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        inline bool operator==(const const_iterator &rhs) const
+        { return cur == rhs.cur && word == rhs.word && bits == rhs.bits; }
+
+        inline bool operator!=(const const_iterator &rhs) const
+        { return !(*this == rhs); }
+
+    private:
+        /// Move to the next non-empty word, or to the end
+        inline void settle()
+        {
+            while (bits == 0)
+            {
+                if (++word == BlockWords)
+                {
+                    word = 0;
+                    if (++cur == end)
+                        return;
+                }
+                bits = cur->words[word];
+            }
+        }
+
+        const Block *cur;
+        const Block *end;
+        unsigned word;
+        uint64_t bits;
+    };
+
+    inline const_iterator begin() const
+    { return {blocks.data(), blocks.data() + blocks.size()}; }
+
+    inline const_iterator end() const
+    { return {blocks.data() + blocks.size(), blocks.data() + blocks.size()}; }
+
+    inline bool empty() const
+    { return blocks.empty(); }
+
+    inline void clear()
+    { blocks.clear(); }
+
+    inline void swap(SparseBitmap &rhs)
+    { blocks.swap(rhs.blocks); }
+
+    /// Number of elements
+    unsigned size() const
+    {
+        unsigned n = 0;
+        for (const Block &b : blocks)
+            n += PtsKernel::popCount(b.words);
+        return n;
+    }
+
+    /// Bytes held by this set
+    inline size_t memoryUsage() const
+    { return blocks.capacity() * sizeof(Block); }
+
+    bool test(unsigned id) const
+    {
+        const Block *b = findBlock(id / BlockBits);
+        return b && (b->words[(id % BlockBits) / WordBits] >> (id % WordBits) & 1);
+    }
+
+    /// Insert an element, returns true if it was not in the set
+    bool set(unsigned id)
+    {
+        uint32_t idx = id / BlockBits;
+        uint64_t mask = uint64_t(1) << (id % WordBits);
+        unsigned w = (id % BlockBits) / WordBits;
+        // Elements mostly arrive in ascending order, so try the last block first
+        size_t pos = blocks.size();
+        if (blocks.empty() || blocks.back().index < idx)
+            blocks.push_back(Block{idx, {}});
+        else
+        {
+            pos = lowerBound(idx);
+            if (pos == blocks.size() || blocks[pos].index != idx)
+                blocks.insert(blocks.begin() + pos, Block{idx, {}});
+            uint64_t &word = blocks[pos].words[w];
+            if (word & mask)
+                return false;
+            word |= mask;
+            return true;
+        }
+        blocks.back().words[w] |= mask;
+        return true;
+    }
+
+    /// Remove an element, returns true if it was in the set
+    bool reset(unsigned id)
+    {
+        size_t pos = lowerBound(id / BlockBits);
+        if (pos == blocks.size() || blocks[pos].index != id / BlockBits)
+            return false;
+        uint64_t mask = uint64_t(1) << (id % WordBits);
+        uint64_t &word = blocks[pos].words[(id % BlockBits) / WordBits];
+        if (!(word & mask))
+            return false;
+        word &= ~mask;
+        if (PtsKernel::isZero(blocks[pos].words))
+            blocks.erase(blocks.begin() + pos);
+        return true;
+    }
+
+    /// this |= rhs, returns true if this changed
+    bool unionWith(const SparseBitmap &rhs)
+    {
+        if (&rhs == this || rhs.empty())
+            return false;
+
+        // Count the blocks of rhs that are missing here
+        size_t missing = 0;
+        for (size_t i = 0, j = 0; j < rhs.blocks.size();)
+        {
+            if (i == blocks.size() || blocks[i].index > rhs.blocks[j].index)
+                ++missing, ++j;
+            else if (blocks[i].index < rhs.blocks[j].index)
+                ++i;
+            else
+                ++i, ++j;
+        }
+
+        bool changed = missing != 0;
+        if (!missing)
+        {
+            for (size_t i = 0, j = 0; j < rhs.blocks.size(); ++i)
+            {
+                if (blocks[i].index == rhs.blocks[j].index)
+                    changed |= PtsKernel::orInto(blocks[i].words, rhs.blocks[j].words), ++j;
+            }
+            return changed;
+        }
+
+        // Merge from the back so that the existing blocks are moved at most once
+        size_t i = blocks.size(), j = rhs.blocks.size(), k = blocks.size() + missing;
+        blocks.resize(k);
+        while (j > 0)
+        {
+            if (i > 0 && blocks[i - 1].index > rhs.blocks[j - 1].index)
+                blocks[--k] = blocks[--i];
+            else if (i > 0 && blocks[i - 1].index == rhs.blocks[j - 1].index)
+            {
+                blocks[--k] = blocks[--i];
+                PtsKernel::orInto(blocks[k].words, rhs.blocks[--j].words);
+            }
+            else
+                blocks[--k] = rhs.blocks[--j];
+        }
+        return changed;
+    }
+
+    /// this &= rhs, returns true if this changed
+    bool intersectWith(const SparseBitmap &rhs)
+    {
+        if (&rhs == this)
+            return false;
+        size_t out = 0, j = 0;
+        bool changed = false;
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            while (j < rhs.blocks.size() && rhs.blocks[j].index < blocks[i].index)
+                ++j;
+            if (j == rhs.blocks.size() || rhs.blocks[j].index != blocks[i].index)
+            {
+                changed = true;
+                continue;
+            }
+            changed |= PtsKernel::andInto(blocks[i].words, rhs.blocks[j].words);
+            if (!PtsKernel::isZero(blocks[i].words))
+                blocks[out++] = blocks[i];
+        }
+        blocks.resize(out);
+        return changed;
+    }
+
+    /// this -= rhs, returns true if this changed
+    bool subtract(const SparseBitmap &rhs)
+    {
+        if (&rhs == this)
+        {
+            bool changed = !empty();
+            clear();
+            return changed;
+        }
+        size_t out = 0, j = 0;
+        bool changed = false;
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            while (j < rhs.blocks.size() && rhs.blocks[j].index < blocks[i].index)
+                ++j;
+            if (j < rhs.blocks.size() && rhs.blocks[j].index == blocks[i].index)
+            {
+                changed |= PtsKernel::andNotInto(blocks[i].words, rhs.blocks[j].words);
+                if (PtsKernel::isZero(blocks[i].words))
+                    continue;
+            }
+            blocks[out++] = blocks[i];
+        }
+        blocks.resize(out);
+        return changed;
+    }
+
+    /// Whether this and rhs share any element
+    bool intersects(const SparseBitmap &rhs) const
+    {
+        for (size_t i = 0, j = 0; i < blocks.size() && j < rhs.blocks.size();)
+        {
+            if (blocks[i].index < rhs.blocks[j].index)
+                ++i;
+            else if (blocks[i].index > rhs.blocks[j].index)
+                ++j;
+            else if (PtsKernel::anyAnd(blocks[i++].words, rhs.blocks[j++].words))
+                return true;
+        }
+        return false;
+    }
+
+    bool operator==(const SparseBitmap &rhs) const
+    {
+        if (blocks.size() != rhs.blocks.size())
+            return false;
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            if (blocks[i].index != rhs.blocks[i].index)
+                return false;
+            for (unsigned w = 0; w < BlockWords; ++w)
+                if (blocks[i].words[w] != rhs.blocks[i].words[w])
+                    return false;
+        }
+        return true;
+    }
+
+    inline bool operator!=(const SparseBitmap &rhs) const
+    { return !(*this == rhs); }
+
+    /// Hash of the contents
+    size_t hash() const
+    {
+        uint64_t h = 0x9e3779b97f4a7c15ULL ^ blocks.size();
+        for (const Block &b : blocks)
+        {
+            h = (h ^ b.index) * 0x100000001b3ULL;
+            for (unsigned w = 0; w < BlockWords; ++w)
+                h = (h ^ b.words[w] ^ (b.words[w] >> 29)) * 0xbf58476d1ce4e5b9ULL;
+        }
+        return h ^ (h >> 31);
+    }
+
+private:
+    inline size_t lowerBound(uint32_t idx) const
+    {
+        size_t lo = 0, hi = blocks.size();
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            if (blocks[mid].index < idx)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    inline const Block *findBlock(uint32_t idx) const
+    {
+        size_t pos = lowerBound(idx);
+        return pos < blocks.size() && blocks[pos].index == idx ? &blocks[pos] : nullptr;
+    }
+
+    std::vector<Block> blocks;
+};
+
+
+/**
+ * Pointer -> points-to set map backed by a vector indexed by node ID.
+ * Besides its set, a node may carry an entry flag; the solver uses it to record the pointers
+ * that are reported even though they point to nothing.
+ */
+template<class SetT>
+class DensePtsMap
+{
+public:
+    using SetType = SetT;
+    /// Updates to distinct, already allocated slots may run concurrently
+    static constexpr bool ConcurrentSlots = true;
+
+    /// Number of slots, i.e. one more than the largest node ID seen
+    inline size_t size() const
+    { return sets.size(); }
+
+    /// Pre-allocate slots for node IDs below n
+    inline void reserve(size_t n)
+    { ensure(n); }
+
+    /// Whether the node has an entry
+    inline bool hasEntry(unsigned n) const
+    { return n < present.size() && present[n]; }
+
+    /// Create an entry for the node
+    inline void touch(unsigned n)
+    {
+        ensure(n + 1);
+        present[n] = true;
+    }
+
+    inline const SetT &getPts(unsigned n) const
+    { return n < sets.size() ? sets[n] : emptySet; }
+
+    /// pts(n) = pts(n) U {o}
+    inline bool addPts(unsigned n, unsigned o)
+    {
+        ensure(n + 1);
+        return sets[n].set(o);
+    }
+
+    /// pts(n) = pts(n) U s
+    inline bool unionPts(unsigned n, const SetT &s)
+    {
+        ensure(n + 1);
+        return sets[n].unionWith(s);
+    }
+
+    /// pts(dst) = pts(dst) U pts(src)
+    inline bool unionPts(unsigned dst, unsigned src)
+    {
+        ensure(dst + 1);
+        if (dst == src || src >= sets.size())
+            return false;
+        return sets[dst].unionWith(sets[src]);
+    }
+
+    /// Move pts(n) into out, leaving pts(n) empty
+    inline void takePts(unsigned n, SetT &out)
+    {
+        out.clear();
+        if (n < sets.size())
+            out.swap(sets[n]);
+    }
+
+    /// pts(n) = {}
+    inline void clearPts(unsigned n)
+    {
+        if (n < sets.size())
+            SetT().swap(sets[n]);
+    }
+
+    /// Bytes held by the map and its sets
+    size_t memoryUsage() const
+    {
+        size_t bytes = sets.capacity() * sizeof(SetT) + present.capacity() / 8;
+        for (const SetT &s : sets)
+            bytes += s.memoryUsage();
+        return bytes;
+    }
+
+private:
+    inline void ensure(size_t n)
+    {
+        if (n > sets.size())
+        {
+            sets.resize(n);
+            present.resize(n, false);
+        }
+    }
+
+    std::vector<SetT> sets;
+    std::vector<bool> present;
+    SetT emptySet;
+};
+
+
+/**
+ * Pointer -> points-to set map over hash-consed sets.
+ * Every distinct set is stored once in a pool and pointers hold the ID of their set, so memory
+ * scales with the number of distinct sets rather than the number of pointers. Unions are
+ * memoised on the (ID, ID) pair. Pool entries are never freed.
+ * Provides the same interface as DensePtsMap.
+ */
+template<class SetT>
+class PersistentPtsMap
+{
+public:
+    using SetType = SetT;
+    /// Slots share the pool and the memo tables, so all updates must be serialised
+    static constexpr bool ConcurrentSlots = false;
+    using SetID = uint32_t;
+
+    /// ID of the empty set
+    static constexpr SetID EmptySetID = 0;
+
+    PersistentPtsMap()
+    { pool.emplace_back(); }
+
+    inline size_t size() const
+    { return setIds.size(); }
+
+    inline void reserve(size_t n)
+    { ensure(n); }
+
+    inline bool hasEntry(unsigned n) const
+    { return n < present.size() && present[n]; }
+
+    inline void touch(unsigned n)
+    {
+        ensure(n + 1);
+        present[n] = true;
+    }
+
+    inline const SetT &getPts(unsigned n) const
+    { return pool[getSetID(n)]; }
+
+    /// ID of the set held by the node
+    inline SetID getSetID(unsigned n) const
+    { return n < setIds.size() ? setIds[n] : EmptySetID; }
+
+    inline bool addPts(unsigned n, unsigned o)
+    {
+        ensure(n + 1);
+        if (pool[setIds[n]].test(o))
+            return false;
+        SetT single;
+        single.set(o);
+        return assign(n, unionSets(setIds[n], intern(std::move(single))));
+    }
+
+    inline bool unionPts(unsigned n, const SetT &s)
+    {
+        ensure(n + 1);
+        if (s.empty())
+            return false;
+        return assign(n, unionSets(setIds[n], intern(SetT(s))));
+    }
+
+    inline bool unionPts(unsigned dst, unsigned src)
+    {
+        ensure(dst + 1);
+        if (dst == src)
+            return false;
+        return assign(dst, unionSets(setIds[dst], getSetID(src)));
+    }
+
+    inline void takePts(unsigned n, SetT &out)
+    {
+        out = getPts(n);
+        clearPts(n);
+    }
+
+    inline void clearPts(unsigned n)
+    {
+        if (n < setIds.size())
+            setIds[n] = EmptySetID;
+    }
+
+    /// Number of distinct sets created so far
+    inline size_t numDistinctSets() const
+    { return pool.size(); }
+
+    size_t memoryUsage() const
+    {
+        size_t bytes = setIds.capacity() * sizeof(SetID) + present.capacity() / 8 + pool.capacity() * sizeof(SetT);
+        for (const SetT &s : pool)
+            bytes += s.memoryUsage();
+        bytes += index.size() * (sizeof(size_t) + sizeof(SetID) + 2 * sizeof(void *));
+        bytes += unionMemo.size() * (sizeof(uint64_t) + sizeof(SetID) + 2 * sizeof(void *));
+        return bytes;
+    }
+
+private:
+    /// Canonical ID of a set
+    SetID intern(SetT &&s)
+    {
+        if (s.empty())
+            return EmptySetID;
+        size_t h = s.hash();
+        auto range = index.equal_range(h);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (pool[it->second] == s)
+                return it->second;
+        }
+        SetID id = pool.size();
+        pool.push_back(std::move(s));
+        index.emplace(h, id);
+        return id;
+    }
+
+    /// ID of the union of two sets
+    SetID unionSets(SetID a, SetID b)
+    {
+        if (a == b || b == EmptySetID)
+            return a;
+        if (a == EmptySetID)
+            return b;
+        uint64_t key = a < b ? ((uint64_t) a << 32 | b) : ((uint64_t) b << 32 | a);
+        auto it = unionMemo.find(key);
+        if (it != unionMemo.end())
+            return it->second;
+        SetT merged = pool[a];
+        merged.unionWith(pool[b]);
+        SetID id = intern(std::move(merged));
+        unionMemo.emplace(key, id);
+        return id;
+    }
+
+    inline bool assign(unsigned n, SetID id)
+    {
+        if (setIds[n] == id)
+            return false;
+        setIds[n] = id;
+        return true;
+    }
+
+    inline void ensure(size_t n)
+    {
+        if (n > setIds.size())
+        {
+            setIds.resize(n, EmptySetID);
+            present.resize(n, false);
+        }
+    }
+
+    std::vector<SetID> setIds;
+    std::vector<bool> present;
+    std::vector<SetT> pool;     ///< ID -> set, ID 0 is the empty set
+    std::unordered_multimap<size_t, SetID> index;   ///< set hash -> IDs
+    std::unordered_map<uint64_t, SetID> unionMemo;  ///< (ID, ID) -> ID of the union
+};
+
+#endif //ANSWERS_POINTSTO_H
@@ -0,0 +1,55 @@
+/**
+ * PtsConvert.cpp
+ * Convert a binary points-to result (.res.bin) into the text format of dumpResult (.res.txt).
+ */
+
+#include "PtsFile.h"
+
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    if (argc != 2 && argc != 3)
+    {
+        std::cerr << "usage: " << argv[0] << " <result.res.bin> [result.res.txt]\n";
+        return 1;
+    }
+    std::string inName = argv[1];
+    std::string outName;
+    if (argc == 3)
+        outName = argv[2];
+    else if (inName.size() > 4 && inName.compare(inName.size() - 4, 4, ".bin") == 0)
+        outName = inName.substr(0, inName.size() - 4) + ".txt";
+    else
+        outName = inName + ".txt";
+
+    PtsFileReader reader;
+    std::string error;
+    if (!reader.open(inName, error))
+    {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    std::ofstream outFile(outName, std::ios::out);
+    if (!outFile)
+    {
+        std::cerr << "error opening " << outName << "\n";
+        return 1;
+    }
+
+    if (reader.isPartial())
+        outFile << "# partial result: sets marked \"in flight\" may still grow\n";
+    for (uint32_t pointer = 0; pointer < reader.getNumIds(); ++pointer)
+    {
+        if (!reader.isReported(pointer))
+            continue;
+        outFile << pointer << " points to: {";
+        for (uint32_t pointee : reader.getPts(pointer))
+        {
+            outFile << pointee << ", ";
+        }
+        outFile << (reader.isInFlight(pointer) ? "} in flight\n" : "}\n");
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * PtsFile.cpp
+ * @author kisslune
+ */
+
+#include "PtsFile.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool PtsFileReader::open(const std::string &path, std::string &error)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(PtsFileHeader))
+    {
+        ::close(fd);
+        error = path + " is too short for a points-to result";
+        return false;
+    }
+    void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        error = "cannot map " + path;
+        return false;
+    }
+    base = mapped;
+    length = st.st_size;
+
+    // Check the header and that every section fits before trusting any offset. numIds is 32 bits, so
+    // the index and bit vectors fit in 64 bits; numObjs is checked against the length without scaling it
+    auto head = static_cast<const PtsFileHeader *>(base);
+    uint64_t indexBytes = ((uint64_t) head->numIds + 1) * sizeof(uint64_t);
+    uint64_t reportedBytes = ptsFileReportedWords(head->numIds) * sizeof(uint64_t);
+    uint64_t fixedBytes = sizeof(PtsFileHeader) + indexBytes + 2 * reportedBytes;
+    if (head->magic != PtsFileMagic || head->version != PtsFileVersion || fixedBytes > length ||
+        (length - fixedBytes) % sizeof(uint32_t) != 0 || head->numObjs != (length - fixedBytes) / sizeof(uint32_t))
+    {
+        close();
+        error = path + " is not a points-to result of this version";
+        return false;
+    }
+    auto bytes = static_cast<const char *>(base) + sizeof(PtsFileHeader);
+    index = reinterpret_cast<const uint64_t *>(bytes);
+    reported = reinterpret_cast<const uint64_t *>(bytes + indexBytes);
+    inFlight = reinterpret_cast<const uint64_t *>(bytes + indexBytes + reportedBytes);
+    objs = reinterpret_cast<const uint32_t *>(bytes + indexBytes + 2 * reportedBytes);
+    // getPts trusts every range to lie within objs: from 0, non-decreasing, up to numObjs
+    bool indexOk = index[0] == 0 && index[head->numIds] == head->numObjs;
+    for (uint32_t n = 0; indexOk && n < head->numIds; ++n)
+        indexOk = index[n] <= index[n + 1];
+    if (!indexOk)
+    {
+        close();
+        error = path + " has a corrupt index";
+        return false;
+    }
+    header = head;
+    return true;
+}
+
+
+void PtsFileReader::close()
+{
+    if (base)
+        munmap(base, length);
+    base = nullptr;
+    length = 0;
+    header = nullptr;
+    index = reported = inFlight = nullptr;
+    objs = nullptr;
+}
+
+
+bool PtsFileReader::pointsTo(uint32_t n, uint32_t o) const
+{
+    PtsFileRange range = getPts(n);
+    return std::binary_search(range.begin(), range.end(), o);
+}
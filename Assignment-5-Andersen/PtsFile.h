@@ -0,0 +1,117 @@
+/**
+ * PtsFile.h
+ * Binary points-to result file, laid out to be memory-mapped and read without parsing.
+ */
+
+#ifndef ANSWERS_PTSFILE_H
+#define ANSWERS_PTSFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * File layout, in host byte order, every section starting 8-byte aligned:
+ *   PtsFileHeader
+ *   uint64_t index[numIds + 1]               objects of pointer n are objs[index[n], index[n + 1])
+ *   uint64_t reported[(numIds + 63) / 64]    bits of the pointers listed even with an empty set
+ *   uint64_t inFlight[(numIds + 63) / 64]    bits of the pointers whose sets may still grow
+ *   uint32_t objs[numObjs]                   sorted object IDs, pointer after pointer
+ */
+struct PtsFileHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t numIds;
+    uint64_t numObjs;
+    uint64_t flags;
+};
+
+const uint64_t PtsFileMagic = 0x5345525354503541ull;     // "A5PTSRES"
+const uint32_t PtsFileVersion = 2;
+
+/// Flag of a result from a run stopped by its budget before the fixpoint
+const uint64_t PtsFilePartial = 1;
+
+/// Number of 64-bit words of the reported and of the in-flight bit vector
+inline uint64_t ptsFileReportedWords(uint32_t numIds)
+{ return (numIds + 63) / 64; }
+
+
+/// The sorted objects of one pointer
+struct PtsFileRange
+{
+    const uint32_t *first;
+    const uint32_t *last;
+
+    inline const uint32_t *begin() const
+    { return first; }
+
+    inline const uint32_t *end() const
+    { return last; }
+
+    inline size_t size() const
+    { return last - first; }
+
+    inline bool empty() const
+    { return first == last; }
+};
+
+
+/**
+ * Read-only view of a mapped points-to result file. Lookups index straight into the mapping.
+ */
+class PtsFileReader
+{
+public:
+    PtsFileReader() = default;
+
+    ~PtsFileReader()
+    { close(); }
+
+    PtsFileReader(const PtsFileReader &) = delete;
+    PtsFileReader &operator=(const PtsFileReader &) = delete;
+
+    /// Map the file at path, returns false (with the reason in error) if it is not a valid result file
+    bool open(const std::string &path, std::string &error);
+    /// Unmap the file
+    void close();
+
+    /// One more than the largest pointer ID in the file
+    inline uint32_t getNumIds() const
+    { return header ? header->numIds : 0; }
+
+    /// The points-to set of pointer n, empty for IDs beyond the file
+    inline PtsFileRange getPts(uint32_t n) const
+    {
+        if (n >= getNumIds())
+            return {nullptr, nullptr};
+        return {objs + index[n], objs + index[n + 1]};
+    }
+
+    /// Whether n is listed in the text result
+    inline bool isReported(uint32_t n) const
+    { return n < getNumIds() && ((reported[n / 64] >> (n % 64)) & 1); }
+
+    /// Whether the result is that of a run stopped before the fixpoint
+    inline bool isPartial() const
+    { return header && (header->flags & PtsFilePartial); }
+
+    /// Whether the set of n may still grow, in a partial result
+    inline bool isInFlight(uint32_t n) const
+    { return n < getNumIds() && ((inFlight[n / 64] >> (n % 64)) & 1); }
+
+    /// Whether pointer n points to object o
+    bool pointsTo(uint32_t n, uint32_t o) const;
+
+private:
+    void *base = nullptr;
+    size_t length = 0;
+    const PtsFileHeader *header = nullptr;
+    const uint64_t *index = nullptr;
+    const uint64_t *reported = nullptr;
+    const uint64_t *inFlight = nullptr;
+    const uint32_t *objs = nullptr;
+};
+
+#endif //ANSWERS_PTSFILE_H
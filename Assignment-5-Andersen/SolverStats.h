@@ -0,0 +1,119 @@
+/**
+ * SolverStats.h
+ * Counters and phase timers of the Andersen solver.
+ */
+
+#ifndef ANSWERS_SOLVERSTATS_H
+#define ANSWERS_SOLVERSTATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Statements that update solver counters; they compile to nothing unless A5_STATS is defined
+#ifdef A5_STATS
+#define A5_STAT(...) do { __VA_ARGS__; } while (0)
+#else
+#define A5_STAT(...) do {} while (0)
+#endif
+
+/**
+ * What the solver did: per-rule firings and new points-to facts, derived copy edges and the
+ * wall-clock time of each phase. Rule counters are only maintained with A5_STATS; phases are
+ * always timed since they cost nothing on the hot path.
+ */
+class SolverStats
+{
+public:
+    enum Rule
+    {
+        Addr, Copy, Load, Store, Gep, NumRules
+    };
+
+    static inline const char *getRuleName(unsigned rule)
+    {
+        static const char *names[NumRules] = {"addr", "copy", "load", "store", "gep"};
+        return names[rule];
+    }
+
+    /// A rule applied to one edge (Addr, Copy) or one edge and object (Load, Store, Gep)
+    inline void fire(Rule rule, uint64_t n = 1)
+    { firings[rule] += n; }
+
+    /// Objects a rule added to points-to sets
+    inline void addFacts(Rule rule, uint64_t n)
+    { newFacts[rule] += n; }
+
+    inline void addCopyEdge()
+    { ++copyEdges; }
+
+    /// Load/Store edge insertions skipped because the object was already handled for that pointer
+    inline void skipInsertions(uint64_t n)
+    { skippedInsertions += n; }
+
+    /// Derived copy edges that another constraint had already added
+    inline void addDuplicateEdge()
+    { ++duplicateEdges; }
+
+    inline void addPhase(const std::string &name, double seconds)
+    { phases.emplace_back(name, seconds); }
+
+    inline uint64_t getFirings(unsigned rule) const
+    { return firings[rule]; }
+
+    inline uint64_t getNewFacts(unsigned rule) const
+    { return newFacts[rule]; }
+
+    inline uint64_t getNumCopyEdges() const
+    { return copyEdges; }
+
+    inline uint64_t getNumSkippedInsertions() const
+    { return skippedInsertions; }
+
+    inline uint64_t getNumDuplicateEdges() const
+    { return duplicateEdges; }
+
+    inline const std::vector<std::pair<std::string, double>> &getPhases() const
+    { return phases; }
+
+    /// Whether the rule counters were compiled in
+    static constexpr bool Enabled =
+#ifdef A5_STATS
+            true;
+#else
+            false;
+#endif
+
+private:
+    uint64_t firings[NumRules] = {};
+    uint64_t newFacts[NumRules] = {};
+    uint64_t copyEdges = 0;
+    uint64_t skippedInsertions = 0;
+    uint64_t duplicateEdges = 0;
+    std::vector<std::pair<std::string, double>> phases;
+};
+
+
+/// Wall-clock time since construction or the last lap
+class PhaseTimer
+{
+public:
+    PhaseTimer() : start(std::chrono::steady_clock::now())
+    {}
+
+    /// Seconds since the last lap, restarting the timer
+    inline double lap()
+    {
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - start).count();
+        start = now;
+        return seconds;
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif //ANSWERS_SOLVERSTATS_H
@@ -0,0 +1,55 @@
+#!/usr/bin/env bash
+# Scaling benchmark of the Andersen solver over synthetic programs (see BenchGen.cpp).
+# Settings come from the environment:
+#   SIZES          approximate constraint-graph node counts (default "1000 10000 100000 1000000")
+#   MIX            addr,copy,load,store,gep statement weights (default 2,4,2,2,1)
+#   CYCLES         probability that a copy is a ring of copies (default 0.05)
+#   FIELDS         pointer fields per object (default 4)
+#   SEED           generator seed (default 1)
+#   ANDERSEN_ARGS  options for andersen (default -reorder, the faster solver), e.g. "-threads=4"
+#   BIN_DIR        directory of andersen and a5benchgen (default: this directory)
+#   OUT            result file (default bench-results.json)
+# Each size is one JSON object in OUT: nodes, facts, solve and analysis seconds, facts per
+# second of solving and peak RSS, so runs can be compared across commits.
+set -euo pipefail
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+BIN_DIR="${BIN_DIR:-$SCRIPT_DIR}"
+SIZES="${SIZES:-1000 10000 100000 1000000}"
+MIX="${MIX:-2,4,2,2,1}"
+CYCLES="${CYCLES:-0.05}"
+FIELDS="${FIELDS:-4}"
+SEED="${SEED:-1}"
+ANDERSEN_ARGS="${ANDERSEN_ARGS:--reorder}"
+OUT="${OUT:-bench-results.json}"
+
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+
+# First number of a "key": value line of the stats file
+stat() {
+  sed -n "s/^ *\"$1\": \([0-9.eE+-]*\).*/\1/p" "$2" | head -n 1
+}
+
+printf '%12s %12s %14s %12s %14s %12s\n' nodes facts facts/sec solve-s analysis-s rss-KiB
+printf "[" > "$OUT"
+sep=""
+for size in $SIZES; do
+  ll="$WORK/bench-$size.ll"
+  "$BIN_DIR/a5benchgen" -nodes="$size" -mix="$MIX" -cycles="$CYCLES" -fields="$FIELDS" \
+    -seed="$SEED" -o="$ll" > /dev/null
+  # shellcheck disable=SC2086
+  "$BIN_DIR/andersen" -stats $ANDERSEN_ARGS "$ll" > "$WORK/andersen-$size.log"
+  stats="$ll.stats.json"
+  nodes="$(stat nodes "$stats")"
+  facts="$(stat facts "$stats")"
+  solve="$(stat 'pointer-analysis\.solve' "$stats")"
+  analysis="$(stat pointer-analysis "$stats")"
+  rss="$(stat peak_rss_kib "$stats")"
+  rate="$(awk -v f="$facts" -v s="$solve" 'BEGIN { printf "%.0f", (s > 0 ? f / s : 0) }')"
+  printf '%12s %12s %14s %12s %14s %12s\n' "$nodes" "$facts" "$rate" "$solve" "$analysis" "$rss"
+  printf '%s\n  {"size": %s, "nodes": %s, "facts": %s, "solve_seconds": %s, "analysis_seconds": %s, "facts_per_second": %s, "peak_rss_kib": %s, "mix": "%s", "cycles": %s, "fields": %s, "seed": %s}' \
+    "$sep" "$size" "$nodes" "$facts" "$solve" "$analysis" "$rate" "$rss" "$MIX" "$CYCLES" "$FIELDS" "$SEED" >> "$OUT"
+  sep=","
+done
+printf '\n]\n' >> "$OUT"
+echo "results written to $OUT"
@@ -0,0 +1,76 @@
+#!/usr/bin/env bash
+# Result checks of the Andersen solver over Test-Cases, run by ctest.
+#   check.sh <andersen> reference   the default solver writes the tracked reference results
+#                                   (Test-Cases/*.bc.res.txt, from the .bc next to them) byte for byte
+#   check.sh <andersen> solvers     the reordering solvers (-reorder, -threads, -wl-policy, -hvn)
+#                                   number field objects alike, so their results are byte-identical
+# CLANG (default $LLVM_DIR/bin/clang, then clang) compiles the .c cases where a check needs them.
+set -euo pipefail
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+ANDERSEN="$1"
+MODE="$2"
+CLANG="${CLANG:-${LLVM_DIR:-}/bin/clang}"
+if [ ! -x "$CLANG" ]; then
+  CLANG="clang"
+fi
+
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+failures=0
+
+# Run andersen with the given options on a copy of a bitcode file in $WORK/<run>, where the
+# result <name>.res.txt is written
+run() {
+  local dir="$WORK/$1" bc="$2"
+  shift 2
+  mkdir -p "$dir"
+  cp "$bc" "$dir/"
+  (cd "$dir" && "$ANDERSEN" "$@" "$(basename "$bc")" > "$(basename "$bc").log" 2>&1) ||
+    { echo "FAIL: andersen $* on $(basename "$bc")"; cat "$dir/$(basename "$bc").log"; failures=$((failures + 1)); }
+}
+
+# Compile the .c cases into $WORK/bc
+compile() {
+  mkdir -p "$WORK/bc"
+  for f in "$SCRIPT_DIR"/Test-Cases/*.c; do
+    "$CLANG" -O0 -g -emit-llvm -c "$f" -o "$WORK/bc/$(basename "${f%.c}").bc"
+  done
+}
+
+# Compare two results byte for byte
+same() {
+  if ! cmp -s "$1" "$2"; then
+    echo "FAIL: $2 differs from $1"
+    diff "$1" "$2" | head -n 20 || true
+    failures=$((failures + 1))
+  fi
+}
+
+case "$MODE" in
+reference)
+  for ref in "$SCRIPT_DIR"/Test-Cases/*.bc.res.txt; do
+    bc="${ref%.res.txt}"
+    [ -f "$bc" ] || continue
+    run reference "$bc"
+    same "$ref" "$WORK/reference/$(basename "$bc").res.txt"
+  done
+  ;;
+solvers)
+  compile
+  for bc in "$WORK"/bc/*.bc; do
+    name="$(basename "$bc")"
+    run reorder "$bc" -reorder
+    for opts in "-threads=2" "-threads=4" "-wl-policy=lifo" "-wl-policy=topo" "-wl-policy=lrf" "-reorder -hvn=false"; do
+      run "solver$opts" "$bc" $opts
+      same "$WORK/reorder/$name.res.txt" "$WORK/solver$opts/$name.res.txt"
+    done
+  done
+  ;;
+*)
+  echo "usage: $0 <andersen> reference|solvers"
+  exit 2
+  ;;
+esac
+
+[ "$failures" -eq 0 ] || { echo "$failures check(s) failed"; exit 1; }
+echo "all checks passed"